@@ -0,0 +1,31 @@
+# Turns a binary file into a C++ source defining NAME::DATA and NAME::SIZE,
+# as declared in HEADER. Run at build time with:
+#   cmake -DINPUT=file -DOUTPUT=file.cpp -DNAME=Namespace -DHEADER=Header.h -P EmbedFile.cmake
+
+file(READ "${INPUT}" CONTENT HEX)
+string(LENGTH "${CONTENT}" HEX_LENGTH)
+math(EXPR SIZE "${HEX_LENGTH} / 2")
+
+# 0x.. literals, 16 per line. CMake regexes have no {n} repetition, so the
+# line pattern is spelled out.
+string(REGEX REPLACE "([0-9a-f][0-9a-f])" "0x\\1," BYTES "${CONTENT}")
+set(LINE_PATTERN "")
+foreach(I RANGE 1 16)
+    string(APPEND LINE_PATTERN "0x[0-9a-f][0-9a-f],")
+endforeach()
+string(REGEX REPLACE "(${LINE_PATTERN})" "\\1\n    " BYTES "${BYTES}")
+
+get_filename_component(INPUT_NAME "${INPUT}" NAME)
+file(WRITE "${OUTPUT}"
+"// Generated from ${INPUT_NAME} by EmbedFile.cmake; do not edit.
+#include \"${HEADER}\"
+
+namespace ${NAME} {
+
+const unsigned char DATA[] = {
+    ${BYTES}
+};
+const std::size_t SIZE = ${SIZE};
+
+} // namespace ${NAME}
+")
@@ -0,0 +1,100 @@
+#ifndef BOARD_H
+#define BOARD_H
+
+#include <array>
+#include <cstdint>
+#include <type_traits>
+
+// A piece is described by up to four rows of a 4-bit-wide mask, bit 0 being
+// the leftmost column of the piece's 4x4 box.
+using PieceRows = std::array<std::uint8_t, 4>;
+// For each column of a piece's box, the lowest row holding a block, or -1
+using PieceBottoms = std::array<std::int8_t, 4>;
+
+// Smallest unsigned word holding Bits bits: the row type of a board
+template <int Bits>
+using RowWord = typename std::conditional<Bits <= 16, std::uint16_t,
+                typename std::conditional<Bits <= 32, std::uint32_t, std::uint64_t>::type>::type;
+
+// Bitboard playfield. Occupancy is kept as one word per row so collision and
+// full-row tests are a few shift-and-AND ops; the per-cell colors live in a
+// separate plane that only the renderer reads. The size is a template
+// parameter, so every loop has a constant trip count and the row word is the
+// narrowest one that fits the width plus the walls. The top surface of every
+// column is cached and kept up to date by place() and clearFullLines(), so
+// the landing row of a piece is a few lookups instead of a row-by-row probe.
+template <int Width, int Height>
+class BasicBoard {
+public:
+    static constexpr int WIDTH = Width;
+    static constexpr int HEIGHT = Height;
+
+private:
+    // Every row word carries PADDING wall bits on both sides of the playfield,
+    // so pieces poking out of the grid collide without explicit range checks.
+    static constexpr int PADDING = 3;
+
+public:
+    using Row = RowWord<WIDTH + 2 * PADDING>;
+    using PieceRows = ::PieceRows;
+    using PieceBottoms = ::PieceBottoms;
+
+    BasicBoard();
+
+    void clear();
+
+    // True if the piece whose 4x4 box has its top-left corner at (x, y) overlaps
+    // a wall, the floor or an occupied cell. Cells above the grid only collide
+    // with the walls.
+    bool collides(const PieceRows& piece, int x, int y) const;
+    // Writes the piece into the grid with the given color id (type + 1).
+    // Cells above the grid are dropped.
+    void place(const PieceRows& piece, int x, int y, int color);
+    // Removes every full row, shifting the rows above down. Returns the number
+    // of rows removed.
+    int clearFullLines();
+    // Replaces the whole grid with WIDTH * HEIGHT color ids, row by row, 0
+    // for an empty cell. For restoring saved games.
+    void setCells(const std::uint8_t* colors);
+
+    // Rows a piece that fits at (x, y) can fall before it lands. Uses the
+    // column surfaces when every block is above them, and probes row by row
+    // only when the piece has been slid under an overhang.
+    int dropDistance(const PieceRows& piece, const PieceBottoms& bottoms, int x, int y) const;
+    // Row of the highest occupied cell in a column, HEIGHT when it is empty
+    int getSurface(int x) const { return mSurface[x]; }
+    int getColumnHeight(int x) const { return HEIGHT - mSurface[x]; }
+
+    bool isOccupied(int x, int y) const;
+    int getCell(int x, int y) const; // Color id, 0 when empty
+    Row getRow(int y) const;         // Occupancy bits, bit x set for column x
+    const std::uint8_t* getRowColors(int y) const { return &mColors[y * WIDTH]; }
+
+private:
+    static constexpr int TOP_ROWS = 4;   // Wall-only rows above the visible grid
+    static constexpr int FLOOR_ROWS = 4; // Solid rows below it
+    static constexpr Row PLAYFIELD_MASK = static_cast<Row>(((static_cast<Row>(1) << WIDTH) - 1) << PADDING);
+    static constexpr Row FULL_ROW = static_cast<Row>(~static_cast<Row>(0));
+    static constexpr Row EMPTY_ROW = static_cast<Row>(FULL_ROW & ~PLAYFIELD_MASK);
+
+    static_assert(WIDTH >= 4 && HEIGHT >= 4, "Board smaller than a piece");
+    static_assert(WIDTH + 2 * PADDING <= 64, "Row word too narrow for WIDTH");
+    static_assert(HEIGHT <= 255, "Column surfaces are stored as bytes");
+
+    void rebuildSurface(int fromY); // Rescans the surfaces, starting at row fromY
+
+    std::array<Row, TOP_ROWS + HEIGHT + FLOOR_ROWS> mRows;
+    std::array<std::uint8_t, WIDTH * HEIGHT> mColors;
+    std::array<std::uint8_t, WIDTH> mSurface;
+};
+
+// The standard board and the variant modes, instantiated in Board.cpp
+using Board = BasicBoard<10, 20>;
+using WideBoard = BasicBoard<20, 20>;
+using TallBoard = BasicBoard<10, 40>;
+
+extern template class BasicBoard<10, 20>;
+extern template class BasicBoard<20, 20>;
+extern template class BasicBoard<10, 40>;
+
+#endif // BOARD_H
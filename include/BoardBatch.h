@@ -0,0 +1,92 @@
+#ifndef BOARD_BATCH_H
+#define BOARD_BATCH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "Board.h"
+#include "Simulation.h"
+#include "Tetromino.h"
+
+// Many games in one structure-of-arrays block, for rolling out large numbers
+// of games without a Simulation object each. Every board's occupancy rows sit
+// in their own 64-byte cache line, and piece, RNG and score state live in
+// parallel arrays. A game follows the same rules as Simulation: a board reset
+// with a seed and advanced with stepGravity() matches a Simulation with that
+// seed stepped by a full fall time per step. Colors and levels are not kept.
+class BoardBatch {
+public:
+    static constexpr int WIDTH = Board::WIDTH;
+    static constexpr int HEIGHT = Board::HEIGHT;
+
+    explicit BoardBatch(std::size_t size);
+
+    std::size_t getSize() const { return mSize; }
+
+    void reset(std::size_t board, std::uint64_t seed); // New game, as Simulation::reset(seed)
+    void resetAll(std::uint64_t firstSeed);            // Board i gets firstSeed + i
+
+    // One gravity step on every running board: the falling piece moves down a
+    // row, or locks if it cannot. Returns the number of boards still running.
+    std::size_t stepGravity();
+    // As Simulation::place: locks the falling piece at the given pose. Returns
+    // the lines cleared, or -1 if the pose overlaps the board or the rotation
+    // is out of range.
+    int place(std::size_t board, const Placement& placement);
+
+    // As Board::collides, for a piece of the given type and rotation
+    bool collides(std::size_t board, int type, int rotation, int x, int y) const;
+    // As Board::clearFullLines. Full rows are found with SSE2 where available.
+    int clearFullLines(std::size_t board);
+
+    Board::Row getRow(std::size_t board, int y) const; // Occupancy bits, bit x set for column x
+    Tetromino getCurrentTetromino(std::size_t board) const;
+    int getNextType(std::size_t board) const { return mNextType[board]; }
+    int getScore(std::size_t board) const { return mScore[board]; }
+    int getLinesCleared(std::size_t board) const { return mLinesCleared[board]; }
+    int getLives(std::size_t board) const { return mLives[board]; }
+    int getPieceCount(std::size_t board) const { return mPieceCount[board]; }
+    bool isGameOver(std::size_t board) const { return mGameOver[board] != 0; }
+
+private:
+    // Row words are laid out as in Board: PADDING wall bits on each side, wall
+    // rows above the grid and solid rows below it, padded to ROW_STRIDE rows.
+    static constexpr int PADDING = 3;
+    static constexpr int TOP_ROWS = 4;
+    static constexpr int ROW_STRIDE = 32; // 64 bytes per board
+    static constexpr Board::Row PLAYFIELD_MASK = ((1u << WIDTH) - 1) << PADDING;
+    static constexpr Board::Row FULL_ROW = static_cast<Board::Row>(~0u);
+    static constexpr Board::Row EMPTY_ROW = FULL_ROW & ~PLAYFIELD_MASK;
+
+    // Collision words, the SSE2 row compare and the 64-byte stride all take a
+    // row to be one 16-bit lane
+    static_assert(sizeof(Board::Row) == 2, "BoardBatch assumes 16-bit board rows");
+    static_assert(TOP_ROWS + HEIGHT + 4 <= ROW_STRIDE, "Board rows do not fit in ROW_STRIDE");
+
+    Board::Row* rows(std::size_t board) { return mRows + board * ROW_STRIDE; }
+    const Board::Row* rows(std::size_t board) const { return mRows + board * ROW_STRIDE; }
+    void clearBoard(std::size_t board);
+    int lock(std::size_t board);
+    void spawn(std::size_t board);
+
+    std::size_t mSize;
+    std::vector<Board::Row> mRowStorage;
+    Board::Row* mRows; // mRowStorage aligned to a cache line
+
+    // Falling piece
+    std::vector<std::uint8_t> mType;
+    std::vector<std::uint8_t> mRotation;
+    std::vector<std::int8_t> mX;
+    std::vector<std::int8_t> mY;
+    std::vector<std::uint8_t> mNextType;
+    std::vector<std::uint64_t> mRandomState;
+
+    // Game stats
+    std::vector<std::int32_t> mScore;
+    std::vector<std::int32_t> mLinesCleared;
+    std::vector<std::int32_t> mPieceCount;
+    std::vector<std::uint8_t> mLives;
+    std::vector<std::uint8_t> mGameOver;
+};
+
+#endif // BOARD_BATCH_H
@@ -0,0 +1,49 @@
+#ifndef BOARD_RENDERER_H
+#define BOARD_RENDERER_H
+
+#include <SFML/Graphics.hpp>
+#include <array>
+#include <cstdint>
+#include "Simulation.h"
+
+// Draws the playfield, the falling piece, its ghost, an optional hint and the
+// next piece preview from one persistent vertex array, in a single draw call.
+// Only the board rows that changed since the previous frame are rebuilt.
+class BoardRenderer {
+public:
+    BoardRenderer(int cellSize, const sf::Vector2i& previewOffset);
+
+    // Brings the vertex array in line with the simulation. fallOffset shifts
+    // the falling piece vertically by a fraction of a cell. hint, when set, is
+    // outlined as a suggested final pose for the falling piece.
+    void update(const Simulation& simulation, float fallOffset = 0.0f, const Placement* hint = nullptr);
+    void draw(sf::RenderTarget& target) const;
+    void invalidate(); // Rebuild every row on the next update
+
+private:
+    static const int VERTICES_PER_QUAD = 6; // Two triangles
+    // Quad layout: backdrop, board cells, hint, ghost, falling piece, preview
+    static const int BACKDROP_QUAD = 0;
+    static const int CELL_QUADS = 1;
+    static const int HINT_QUADS = CELL_QUADS + Board::WIDTH * Board::HEIGHT;
+    static const int HINT_EDGE_COUNT = 16; // One bar per cell side; sides shared by two cells stay empty
+    static const int GHOST_QUADS = HINT_QUADS + HINT_EDGE_COUNT;
+    static const int PIECE_QUADS = GHOST_QUADS + 4;
+    static const int PREVIEW_QUADS = PIECE_QUADS + 4;
+    static const int QUAD_COUNT = PREVIEW_QUADS + 4;
+
+    void setQuad(int quad, const sf::Vector2f& position, const sf::Vector2f& size, const sf::Color& color);
+    void updateRow(const Board& board, int y);
+    void updatePiece(int firstQuad, const Tetromino* tetromino, const sf::Vector2f& offset, const sf::Color& color);
+    void updateHint(const Tetromino* tetromino); // Outlines the piece's cells, or hides the outline
+
+    int mCellSize;
+    sf::Vector2i mPreviewOffset;
+    sf::VertexArray mVertices;
+
+    // Board colors as of the last update, to find the rows that changed
+    std::array<std::array<std::uint8_t, Board::WIDTH>, Board::HEIGHT> mDrawnRows;
+    bool mValid;
+};
+
+#endif // BOARD_RENDERER_H
@@ -0,0 +1,15 @@
+#ifndef EMBEDDED_FONT_H
+#define EMBEDDED_FONT_H
+
+#include <cstddef>
+
+// DejaVu Sans (assets/DejaVuSans.ttf), compiled into the binary so the game
+// needs no font on the system
+namespace EmbeddedFont {
+
+extern const unsigned char DATA[];
+extern const std::size_t SIZE;
+
+} // namespace EmbeddedFont
+
+#endif // EMBEDDED_FONT_H
@@ -2,68 +2,155 @@
 #define GAME_H
 
 #include <SFML/Graphics.hpp>
-#include <vector>
+#include <cstdint>
 #include <memory>
+#include <string>
+#include <vector>
 #include <algorithm>
-#include <chrono> // For fall timer
-#include "Tetromino.h"
+#include "BoardRenderer.h"
+#include "InputHandler.h"
+#include "LookaheadSearch.h"
+#include "MappedFile.h"
+#include "PacingStats.h"
+#include "Replay.h"
+#include "ScoreStore.h"
+#include "Simulation.h"
+#include "SpectatorServer.h"
+
+struct GameSettings {
+    unsigned tickRate = 60;       // Fixed simulation ticks per second
+    unsigned frameRateLimit = 60; // Rendered frames per second, 0 for no limit
+    bool verticalSync = false;
+    bool printPacingStats = false; // Print pacing counters once per second
+    std::string recordDirectory;  // Save a replay of every game there when set
+    std::string replayPath;       // Play this replay instead of a live game
+    unsigned replaySpeed = 1;     // Replay ticks per real tick
+    bool profile = false;         // Start with the profiler and its overlay on
+    std::string tracePath = "tetris-trace.json"; // Where F4 and exit write the trace
+    std::string scorePath = "scores.dat"; // Leaderboard and per-game stats
+    InputTiming inputTiming;      // DAS, ARR and soft drop speed
+    unsigned spectatorPort = 0;   // Stream the game to spectators on this loopback port, 0 for off
+    std::string spectatorSocket;  // Or on this Unix socket
+    std::string savePath = "savegame.dat"; // Where F5 saves the running game and F9 resumes it from
+    bool hint = false;            // Start with the move hint on (toggle with H)
+    float hintBudget = 0.005f;    // Seconds the hint search may take per piece
+};
 
 class Game {
 public:
-    Game();
+    explicit Game(const GameSettings& settings = GameSettings());
     void run();
 
 private:
     enum GameState { MENU, PLAYING, GAME_OVER };
-    void clearFullLines();
-    sf::Font loadFont(const std::string& fontPath); // Helper function
-    void spawnTetromino(); // New method to spawn a tetromino
+    static sf::Font loadFont(sf::Time& loadTime); // Opens the embedded font
+    void prewarmGlyphs(); // Rasterizes the HUD's glyphs before the first frame
+    void reportStartup();
 
     void processEvents();
-    void update(sf::Time deltaTime);
-    void render();
-    void drawGrid();
+    void handleEvent(const sf::Event& event);
+    void handleKey(sf::Keyboard::Scancode scancode, bool pressed);
+    double inputTime() const; // Seconds on the input clock
+    // Applies the inputs due before the given input time, without advancing
+    // the simulation's clock
+    void applyInputs(double before);
+    void update(double tickEnd); // Advances the game by one fixed tick ending at tickEnd (input time)
+    void render(float alpha); // alpha: progress towards the next tick, for interpolation
     void restartGame(); // New method
+    void startRecording();
+    void saveGame();   // F5: writes the running game to mSettings.savePath
+    void resumeGame(); // F9: continues the game saved there
+    void toggleProfiler();
+    void writeTrace();
+    void updateProfilerOverlay();
+    void updateHud(); // Re-lays out HUD texts whose values changed
+    void publishToSpectators();
+    void updateHint(); // Searches for the falling piece's best placement once per piece
+    bool updateBackground(); // Steps the level color transition; true while it animates
+
+    static const int MAX_TICKS_PER_FRAME = 5; // Catch-up limit after a stall
+    static constexpr float SPECTATOR_WAKE_SECONDS = 0.25f; // Longest sleep on the game over screen while spectators can connect
 
-    bool checkCollision(const Tetromino& tetromino, int offsetX, int offsetY, const std::vector<sf::Vector2i>* newShape = nullptr) const;
+    // Startup timing. The clock is the first member, so it covers the window
+    // and font; mFontLoadTime is set while mFont is initialized.
+    sf::Clock mStartupClock;
+    sf::Time mFontLoadTime;
+    sf::Time mGlyphPrewarmTime;
+    sf::Time mConstructionTime;
+    bool mFirstFrameShown;
 
+    GameSettings mSettings;
     sf::RenderWindow mWindow;
     GameState mState;
     sf::Font mFont;
     sf::Text mMenuText_Start;
     sf::Text mMenuText_Close;
 
-    static const int GRID_WIDTH = 10;
-    static const int GRID_HEIGHT = 20; // Corrected: removed duplicate 'int'
-    static const int CELL_SIZE = 25;
+    static constexpr int GRID_WIDTH = Simulation::BoardType::WIDTH;
+    static constexpr int GRID_HEIGHT = Simulation::BoardType::HEIGHT;
+    static constexpr int CELL_SIZE = 25;
+
+    Simulation mSimulation; // Board, pieces, scoring, levels and lives
+    BoardRenderer mBoardRenderer; // Board, pieces and preview in one draw call
+    PacingStats mPacingStats;
 
-    std::vector<std::vector<int>> mGrid;
-    std::unique_ptr<Tetromino> mCurrentTetromino; // New member
-    std::unique_ptr<Tetromino> mNextTetromino;    // New member for next Tetromino preview
-    // Fall timer
-    sf::Time mFallTime;
+    // Keys are timestamped on mInputClock as they are polled, and held keys
+    // repeat on InputHandler's timers
+    InputHandler mInputHandler;
+    sf::Clock mInputClock;
+    double mUndisplayedPressTime; // Earliest key press applied since the last display, or -1
 
-    sf::Time mTimeSinceLastFall;
+    // Profiler overlay, toggled with F3; F4 writes a Chrome trace
+    sf::Text mProfilerText;
+    sf::Clock mProfilerOverlayClock; // Refreshes the overlay twice per second
+    bool mTraceWritten;
+    float mTickSeconds;
+    std::uint32_t mGameTick; // Ticks since the current game started
+
+    // Replay recording and playback
+    ReplayWriter mReplayWriter;
+    MappedFile mReplayFile;
+    ReplayPlayer mReplayPlayer;
+    bool mReplayMode;
+
+    SpectatorServer mSpectators; // Mirrors the game to local sockets, when enabled
+
+    // Move hint, toggled with H: where LookaheadSearch would put the piece
+    std::unique_ptr<LookaheadSearch> mHintSearch; // Created, with its threads, when first shown
+    bool mShowHint;
+    bool mHintValid;
+    Placement mHint;
+    int mHintPieceCount; // Piece the hint is for
+
+    // Falling piece as of the previous tick, to interpolate its fall
+    Cell mPreviousPiecePosition;
+    int mPreviousPieceRotation;
+    int mPreviousPieceCount;
 
-    // Game stats
-    int mScore;
-    int mLevel;
     int mPreviousLevel; // To detect level changes for background transition
-    int mLinesCleared;
-    int mPointsToNextLevel; // New member for tracking level progression
-    int mLives; // New member for player lives
     sf::Text mScoreText;
     sf::Text mLevelText;
-    int mBestScore; // New member for best score
+    ScoreStore mScores; // Loaded at startup; only submit() at game over changes it, and a worker writes it
     sf::Text mBestScoreText; // New member for best score display
-    void saveScores(); // New method for saving scores
-    void loadScores(); // New method for loading scores
+    sf::Text mLivesText;
+    sf::Text mNextText;
+    sf::Text mGameOverText;
+    // Values the HUD texts show, so strings are only rebuilt on change
+    int mShownScore;
+    int mShownLevel;
+    int mShownLives;
+    int mShownBestScore;
 
     // Background color transition members
     sf::Color mCurrentBgColor;
+    sf::Color mStartBgColor; // Color when the transition started
     sf::Color mTargetBgColor;
     sf::Clock mLevelTransitionClock;
     sf::Time mLevelTransitionDuration;
+    bool mTransitionActive;
+
+    // Menu and game over are only redrawn when something on them changed
+    bool mDirty;
 };
 
 #endif // GAME_H
\ No newline at end of file
@@ -0,0 +1,61 @@
+#ifndef INPUT_HANDLER_H
+#define INPUT_HANDLER_H
+
+#include <array>
+#include "Simulation.h"
+
+// Auto-repeat timing for held keys, in seconds
+struct InputTiming {
+    float das = 0.167f;      // Delayed auto-shift: how long a move key is held before it repeats
+    float arr = 0.033f;      // Auto-repeat rate: time between repeated moves
+    float softDrop = 0.033f; // Time between rows while soft drop is held
+};
+
+// Turns timestamped key presses and releases into simulation inputs. Held keys
+// repeat on their own timers instead of the OS key repeat, so pieces move at
+// the same rate on every machine. Times are seconds on whatever clock the
+// caller keeps; each input is handed out with the time it is due, so the
+// caller can apply it on the tick it falls in rather than at the next frame.
+class InputHandler {
+public:
+    enum class Action { Left, Right, SoftDrop, HardDrop, Rotate, COUNT };
+
+    struct Event {
+        double time;                 // When the key was pressed or the repeat fell due
+        SimulationBase::Input input;
+        bool repeat;                 // Generated by auto-repeat, not a key press
+    };
+
+    explicit InputHandler(const InputTiming& timing = InputTiming());
+
+    void press(Action action, double time); // Presses of a key already down are ignored
+    void release(Action action, double time);
+    void releaseAll(double time); // When the window loses focus, so no key sticks
+    void reset();                 // Forgets held keys and presses not yet handed out
+
+    // Takes the earliest input due before the given time, in time order.
+    // Returns false when none is due.
+    bool next(double before, Event& event);
+
+    const InputTiming& getTiming() const { return mTiming; }
+
+private:
+    struct Key {
+        bool held = false;
+        bool pressPending = false; // Pressed, but not handed out by next() yet
+        double pressTime = 0.0;
+        double nextRepeat = 0.0;
+    };
+
+    bool repeats(Action action) const; // Whether the key auto-repeats while held now
+    double repeatInterval(Action action) const;
+    Key& key(Action action) { return mKeys[static_cast<int>(action)]; }
+
+    InputTiming mTiming;
+    std::array<Key, static_cast<int>(Action::COUNT)> mKeys;
+    // Of Left and Right, the one pressed last. It alone repeats while both are
+    // held, and releasing it hands the repeat back to the other after a new DAS.
+    Action mHorizontal;
+};
+
+#endif // INPUT_HANDLER_H
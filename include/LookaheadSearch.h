@@ -0,0 +1,103 @@
+#ifndef LOOKAHEAD_SEARCH_H
+#define LOOKAHEAD_SEARCH_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+#include "PlacementSearch.h"
+#include "Simulation.h"
+#include "WorkStealingPool.h"
+
+// Lock-free cache of board values shared by every search thread. Each entry
+// is two words written without a lock: the value, and the key XORed with the
+// value. A reader recomputes the key from both, so an entry torn by two
+// concurrent writers reads as a miss instead of a wrong value. Entries are
+// always replaced, since the search depth is part of the key.
+class TranspositionTable {
+public:
+    explicit TranspositionTable(int sizeBits); // 2^sizeBits entries of 16 bytes
+
+    bool probe(std::uint64_t key, float& value) const;
+    void store(std::uint64_t key, float value);
+
+private:
+    struct Entry {
+        std::atomic<std::uint64_t> check; // key ^ data
+        std::atomic<std::uint64_t> data;  // Valid bit above the value's float bits
+    };
+
+    std::unique_ptr<Entry[]> mEntries;
+    std::uint64_t mMask;
+};
+
+// Expectimax search over the pieces to come, for the hint mode and the
+// lookahead policy. The falling piece and the next piece are known, so their
+// plies take the best of every reachable placement (from PlacementSearch).
+// Each later ply is a chance node that averages over the seven piece types,
+// each dropped straight down in its best rotation and column. Leaves are
+// scored with the PlacementSearch heuristic, and a move that tops out the
+// board scores LOSS_SCORE.
+//
+// The placements of the falling piece are searched in parallel on a
+// WorkStealingPool. Chance node values go into a TranspositionTable keyed by
+// a Zobrist hash of the board and the plies left; the table outlives the
+// search, so the next move reuses most of this one's subtrees. The search
+// deepens one ply at a time until the time budget runs out and answers with
+// the deepest ply that completed; the first ply always completes.
+class LookaheadSearch {
+public:
+    static constexpr int MAX_DEPTH = 8; // Pieces placed, the falling one included
+    static constexpr float LOSS_SCORE = -10000.0f;
+
+    // With threadCount 0 the search runs on the calling thread only
+    explicit LookaheadSearch(unsigned threadCount = std::thread::hardware_concurrency(), int tableBits = 18,
+                             const HeuristicWeights& weights = HeuristicWeights());
+
+    LookaheadSearch(const LookaheadSearch&) = delete;
+    LookaheadSearch& operator=(const LookaheadSearch&) = delete;
+
+    // Best placement for the falling piece. A budget of 0 or less means no
+    // time limit. Returns false if the piece cannot move at all.
+    bool findBest(const Simulation& simulation, Placement& best, double budgetSeconds, int maxDepth = MAX_DEPTH);
+
+    // About the last findBest
+    int getCompletedDepth() const { return mCompletedDepth; }
+    long long getChanceNodes() const { return mChanceNodes.load(); }
+    long long getTableHits() const { return mTableHits.load(); }
+
+    // Zobrist hash of the occupied cells
+    static std::uint64_t hashBoard(const Board& board);
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    float rootChildValue(int index, int depth); // Placement index of the falling piece
+    float knownPieceValue(const Board& board, int type, int depth, PlacementSearch& search);
+    float chanceValue(const Board& board, int depth);
+    float dropValue(const Board& board, int type, int depth);
+    bool outOfTime();
+
+    std::unique_ptr<WorkStealingPool> mPool; // Null when searching on the caller's thread
+    TranspositionTable mTable;
+    HeuristicWeights mWeights;
+
+    // The position being searched
+    Board mBoard;
+    int mCurrentType;
+    int mNextType;
+    PlacementSearch mRootSearch;
+    std::vector<std::unique_ptr<PlacementSearch>> mChildSearches; // One per root placement, kept between searches
+    std::vector<float> mRootValues;
+
+    bool mHasDeadline;
+    Clock::time_point mDeadline;
+    std::atomic<bool> mAborted;
+    std::atomic<long long> mChanceNodes;
+    std::atomic<long long> mTableHits;
+    int mCompletedDepth;
+};
+
+#endif // LOOKAHEAD_SEARCH_H
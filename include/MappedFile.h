@@ -0,0 +1,32 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Read-only view of a whole file. Uses mmap where available, so large files
+// are paged in on demand; elsewhere the file is read into memory.
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool open(const std::string& path);
+    void close();
+
+    const std::uint8_t* getData() const { return mData; }
+    std::size_t getSize() const { return mSize; }
+
+private:
+    const std::uint8_t* mData = nullptr;
+    std::size_t mSize = 0;
+    bool mMapped = false;
+    std::vector<std::uint8_t> mBuffer; // Fallback when the file is not mapped
+};
+
+#endif // MAPPED_FILE_H
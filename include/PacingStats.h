@@ -0,0 +1,65 @@
+#ifndef PACING_STATS_H
+#define PACING_STATS_H
+
+#include <ostream>
+
+// Frame pacing counters for a fixed-timestep loop: simulation ticks per
+// second, frame times, frames that overran their deadline and the time from
+// a key press to the frame that shows it. Counters are gathered over
+// one-second windows, plus running totals.
+class PacingStats {
+public:
+    struct Window {
+        float ticksPerSecond = 0.0f;
+        float framesPerSecond = 0.0f;
+        float averageFrameMs = 0.0f;
+        float maxFrameMs = 0.0f;
+        int missedDeadlines = 0; // Frames that took over 1.5x the frame budget
+        int droppedTicks = 0;    // Ticks skipped to recover from a stall
+        int inputs = 0;          // Key presses shown on screen
+        float averageInputLatencyMs = 0.0f;
+        float maxInputLatencyMs = 0.0f;
+    };
+
+    // frameBudget is the target frame time in seconds
+    explicit PacingStats(float frameBudget);
+
+    // Records one frame. Returns true when it completed a window, whose
+    // counters are then available from getLastWindow().
+    bool recordFrame(float frameTime, int ticks, int droppedTicks);
+    // Records the time from a key press to the display of the first frame
+    // showing its effect, in seconds
+    void recordInputLatency(float latency);
+
+    const Window& getLastWindow() const { return mLastWindow; }
+    void printSummary(std::ostream& out) const;
+
+private:
+    float mFrameBudget;
+
+    // Current window
+    float mWindowTime;
+    float mMaxFrameTime;
+    int mFrames;
+    int mTicks;
+    int mMissedDeadlines;
+    int mDroppedTicks;
+    int mInputs;
+    float mInputLatencySum;
+    float mMaxInputLatency;
+    Window mLastWindow;
+
+    // Totals since start
+    float mTotalTime;
+    long long mTotalFrames;
+    long long mTotalTicks;
+    long long mTotalMissedDeadlines;
+    long long mTotalDroppedTicks;
+    long long mTotalInputs;
+    double mTotalInputLatency;
+    float mTotalMaxInputLatency;
+};
+
+std::ostream& operator<<(std::ostream& out, const PacingStats::Window& window);
+
+#endif // PACING_STATS_H
@@ -0,0 +1,77 @@
+#ifndef PLACEMENT_SEARCH_H
+#define PLACEMENT_SEARCH_H
+
+#include <array>
+#include <bitset>
+#include <cstdint>
+#include "Board.h"
+#include "Simulation.h"
+#include "Tetromino.h"
+
+// Weights of the board heuristic; higher scores are better boards
+struct HeuristicWeights {
+    float aggregateHeight = -0.51f;
+    float linesCleared = 0.76f;
+    float holes = -0.36f;
+    float bumpiness = -0.18f;
+};
+
+// Enumerates every final placement the falling piece can reach from its
+// current pose using the same moves as Game::processEvents: left, right, soft
+// drop and clockwise rotation with wall kicks. It is a breadth-first walk over
+// (x, y, rotation) states with fixed-size buffers, so it allocates nothing.
+// Placements that cover the same cells (e.g. the four O rotations) are
+// reported once, and placements that would lock out above the top row (see
+// Simulation::lock) are not reported.
+class PlacementSearch {
+public:
+    // Box positions a piece can take: x from -3 (a box column hanging over the
+    // left wall) to the last column, y from the wall-only rows above the grid
+    // to the floor
+    static constexpr int MIN_X = -3;
+    static constexpr int MIN_Y = -4;
+    static constexpr int X_RANGE = Board::WIDTH - MIN_X;
+    static constexpr int Y_RANGE = Board::HEIGHT + 1 - MIN_Y;
+    static constexpr int STATE_COUNT = Tetromino::ROTATION_COUNT * X_RANGE * Y_RANGE;
+
+    // Finds the placements reachable by piece on board; returns how many
+    int search(const Board& board, const Tetromino& piece);
+
+    int getPlacementCount() const { return mPlacementCount; }
+    const Placement& getPlacement(int index) const { return mPlacements[index]; }
+    long long getNodesVisited() const { return mNodesVisited; } // Since construction
+
+    // Searches, scores every placement and returns the best one. Returns
+    // false if the piece cannot move at all.
+    bool findBest(const Board& board, const Tetromino& piece, Placement& best,
+                  const HeuristicWeights& weights = HeuristicWeights());
+
+    // Lowest rotation of the piece that covers the same cells as rotation,
+    // so symmetric orientations (the four O rotations, say) count once
+    static int canonicalRotation(int type, int rotation);
+
+    // Heuristic value of the board left by locking a piece of the given type
+    // at placement, computed on the row masks only
+    static float scorePlacement(const Board& board, int type, const Placement& placement,
+                                const HeuristicWeights& weights = HeuristicWeights());
+    // Heuristic value of a board after linesCleared lines were removed
+    static float evaluate(const Board& board, int linesCleared,
+                          const HeuristicWeights& weights = HeuristicWeights());
+
+private:
+    using Rows = std::array<Board::Row, Board::HEIGHT>;
+    static float evaluateRows(const Rows& rows, int linesCleared, const HeuristicWeights& weights);
+
+    static int stateIndex(int x, int y, int rotation) {
+        return (rotation * Y_RANGE + (y - MIN_Y)) * X_RANGE + (x - MIN_X);
+    }
+
+    std::bitset<STATE_COUNT> mVisited;
+    std::bitset<STATE_COUNT> mFinalSeen; // Final placements, by canonical rotation
+    std::array<std::uint16_t, STATE_COUNT> mQueue;
+    std::array<Placement, STATE_COUNT> mPlacements;
+    int mPlacementCount = 0;
+    long long mNodesVisited = 0;
+};
+
+#endif // PLACEMENT_SEARCH_H
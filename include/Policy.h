@@ -0,0 +1,54 @@
+#ifndef POLICY_H
+#define POLICY_H
+
+#include <memory>
+#include <string>
+#include "LookaheadSearch.h"
+#include "PlacementSearch.h"
+#include "Random.h"
+#include "Simulation.h"
+
+// Chooses where the falling piece should land. Policies may keep state (a
+// random generator, search buffers), so each game gets its own instance.
+class PlacementPolicy {
+public:
+    virtual ~PlacementPolicy() = default;
+    // Returns false if the piece has nowhere to go
+    virtual bool choose(const Simulation& simulation, Placement& placement) = 0;
+};
+
+// Drops the piece straight down in a random column and rotation
+class RandomPolicy : public PlacementPolicy {
+public:
+    explicit RandomPolicy(std::uint64_t seed);
+    bool choose(const Simulation& simulation, Placement& placement) override;
+
+private:
+    Random mRandom;
+};
+
+// Searches every reachable placement and keeps the one leaving the best board
+class GreedyPolicy : public PlacementPolicy {
+public:
+    bool choose(const Simulation& simulation, Placement& placement) override;
+
+private:
+    PlacementSearch mSearch;
+};
+
+// Also weighs where the next piece could go (LookaheadSearch), searched on
+// the caller's thread to a fixed depth, so games stay reproducible
+class LookaheadPolicy : public PlacementPolicy {
+public:
+    explicit LookaheadPolicy(int depth);
+    bool choose(const Simulation& simulation, Placement& placement) override;
+
+private:
+    LookaheadSearch mSearch;
+    int mDepth;
+};
+
+// Creates the policy called name ("random", "greedy" or "lookahead"), or nullptr
+std::unique_ptr<PlacementPolicy> makePolicy(const std::string& name, std::uint64_t seed);
+
+#endif // POLICY_H
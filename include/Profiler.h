@@ -0,0 +1,108 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Timing probes recorded into a fixed-size ring buffer. Recording is lock-free
+// and safe from any thread; once the buffer is full the oldest events are
+// overwritten. Probes cost one atomic load while profiling is off, and the
+// buffer is only allocated the first time profiling is enabled.
+class Profiler {
+public:
+    static constexpr std::size_t DEFAULT_CAPACITY = 1 << 16; // Events kept
+
+    struct Event {
+        const char* name;        // Probe name, a string literal
+        std::uint64_t startNs;   // Since the profiler was created
+        std::uint64_t durationNs;
+        std::uint32_t thread;    // Small per-thread id, in order of first use
+    };
+
+    struct ProbeStats {
+        std::string name;
+        std::size_t count;
+        double p50Ms;
+        double p99Ms;
+        double maxMs;
+    };
+
+    // Capacity is rounded up to a power of two
+    explicit Profiler(std::size_t capacity = DEFAULT_CAPACITY);
+
+    Profiler(const Profiler&) = delete;
+    Profiler& operator=(const Profiler&) = delete;
+
+    // Process-wide profiler used by ProfileScope
+    static Profiler& instance();
+
+    // Call from one thread at a time; probes may run concurrently
+    void setEnabled(bool enabled);
+    bool isEnabled() const { return mEnabled.load(std::memory_order_acquire); }
+
+    std::uint64_t now() const; // Nanoseconds since the profiler was created
+    void record(const char* name, std::uint64_t startNs, std::uint64_t durationNs);
+    // Hides the events recorded so far from later snapshots. Safe while other
+    // threads record: events are numbered, and a clear only moves the number
+    // snapshots start from, so no slot is reset under a writer.
+    void clear();
+
+    // Events still in the buffer, oldest first. Events being written while
+    // the snapshot is taken are skipped.
+    std::vector<Event> snapshot() const;
+    // p50/p99/max per probe over the buffered events, in order of first use
+    std::vector<ProbeStats> summarize() const;
+
+    // Chrome trace-event JSON, for chrome://tracing or Perfetto
+    void writeChromeTrace(std::ostream& out) const;
+    bool writeChromeTrace(const std::string& path) const;
+
+private:
+    // Each field is a relaxed atomic so a reader can race a writer safely; the
+    // sequence number tells the reader whether the copy it made is consistent.
+    struct Slot {
+        std::atomic<std::uint64_t> sequence; // Event index + 1, 0 while written
+        std::atomic<const char*> name;
+        std::atomic<std::uint64_t> startNs;
+        std::atomic<std::uint64_t> durationNs;
+        std::atomic<std::uint32_t> thread;
+    };
+
+    std::unique_ptr<Slot[]> mSlots; // Allocated when first enabled
+    std::size_t mCapacity;
+    std::atomic<std::uint64_t> mNextIndex;
+    std::atomic<std::uint64_t> mClearedIndex; // Snapshots start at this event
+    std::atomic<bool> mEnabled;
+    std::int64_t mEpoch; // steady_clock ticks at creation
+};
+
+// Records the time from construction to destruction under a probe name, if
+// profiling was enabled at construction. The name must outlive the profiler,
+// so pass a string literal.
+class ProfileScope {
+public:
+    explicit ProfileScope(const char* name, Profiler& profiler = Profiler::instance())
+        : mProfiler(profiler), mName(name), mActive(profiler.isEnabled()), mStartNs(mActive ? profiler.now() : 0) {}
+
+    ~ProfileScope() {
+        if (mActive) {
+            mProfiler.record(mName, mStartNs, mProfiler.now() - mStartNs);
+        }
+    }
+
+    ProfileScope(const ProfileScope&) = delete;
+    ProfileScope& operator=(const ProfileScope&) = delete;
+
+private:
+    Profiler& mProfiler;
+    const char* mName;
+    bool mActive;
+    std::uint64_t mStartNs;
+};
+
+#endif // PROFILER_H
@@ -0,0 +1,31 @@
+#ifndef RANDOM_H
+#define RANDOM_H
+
+#include <cstdint>
+
+// SplitMix64 generator. Unlike std::mt19937 with std::uniform_int_distribution
+// its output is specified exactly, so a seed produces the same pieces with
+// every compiler and standard library, and its whole state is one word.
+class Random {
+public:
+    explicit Random(std::uint64_t seed = 0) : mState(seed) {}
+
+    std::uint64_t next() {
+        std::uint64_t z = (mState += 0x9E3779B97F4A7C15ull);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return z ^ (z >> 31);
+    }
+
+    // Uniform integer in [0, bound), by multiply-shift of the top 32 bits
+    int nextInt(int bound) {
+        return static_cast<int>(((next() >> 32) * static_cast<std::uint64_t>(bound)) >> 32);
+    }
+
+    std::uint64_t getState() const { return mState; }
+
+private:
+    std::uint64_t mState;
+};
+
+#endif // RANDOM_H
@@ -0,0 +1,102 @@
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <string>
+#include "Simulation.h"
+
+// A replay holds one game: a fixed 24-byte header with the seed and the tick
+// rate, then one record per input. A record is the number of ticks since the
+// previous record as a LEB128 varint, followed by the input as one byte. The
+// last record has the input END_OF_GAME. All fields are little-endian, so a
+// replay can be appended to while the game runs and decoded in place from a
+// memory mapping.
+namespace ReplayFormat {
+
+constexpr char MAGIC[4] = {'T', 'R', 'P', 'L'};
+constexpr std::uint16_t VERSION = 1;
+constexpr std::size_t HEADER_SIZE = 24; // Magic, version, 2 reserved, tick rate, 4 reserved, seed
+constexpr std::uint8_t END_OF_GAME = 0xFF;
+constexpr const char* EXTENSION = ".tetreplay";
+
+// Length of a simulation tick. The front end and playback must both use it so
+// gravity sees bit-identical time steps.
+inline float tickSeconds(std::uint32_t tickRate) {
+    return 1.0f / tickRate;
+}
+
+} // namespace ReplayFormat
+
+struct ReplayHeader {
+    std::uint64_t seed;
+    std::uint32_t tickRate;
+};
+
+struct ReplayEvent {
+    std::uint32_t tick; // Ticks completed before the input was applied
+    Simulation::Input input;
+    bool endOfGame;
+};
+
+// Streams a game to disk as it is played. Records are buffered and flushed
+// when the game ends; a file cut short still plays back up to its last
+// complete record.
+class ReplayWriter {
+public:
+    bool open(const std::string& path, const ReplayHeader& header);
+    void record(std::uint32_t tick, Simulation::Input input);
+    void finish(std::uint32_t tick); // Writes the end-of-game record and closes
+    bool isOpen() const { return mFile.is_open(); }
+
+private:
+    void writeRecord(std::uint32_t tick, std::uint8_t input);
+
+    std::ofstream mFile;
+    std::uint32_t mLastTick = 0;
+};
+
+// Decodes a replay held in memory, without copying it
+class ReplayReader {
+public:
+    bool open(const std::uint8_t* data, std::size_t size); // Checks the header
+    const ReplayHeader& getHeader() const { return mHeader; }
+    // Returns false at the end of the data or on a truncated record
+    bool next(ReplayEvent& event);
+
+private:
+    const std::uint8_t* mData = nullptr;
+    std::size_t mSize = 0;
+    std::size_t mOffset = 0;
+    std::uint32_t mTick = 0;
+    ReplayHeader mHeader = {};
+};
+
+// Drives a Simulation from a replay one tick at a time
+class ReplayPlayer {
+public:
+    bool open(const std::uint8_t* data, std::size_t size);
+    const ReplayHeader& getHeader() const { return mReader.getHeader(); }
+
+    void start(Simulation& simulation); // Resets it with the recorded seed
+    // Applies the inputs recorded for the current tick, then advances the
+    // simulation by one tick. Returns false once the replay is over.
+    // afterStep, when set, runs after every Simulation::step, so a caller can
+    // see each lock even when several happen in one tick.
+    bool tick(Simulation& simulation, const std::function<void()>& afterStep = nullptr);
+    bool isFinished() const { return mFinished; }
+    std::uint32_t getTick() const { return mTick; }
+
+private:
+    ReplayReader mReader;
+    ReplayEvent mPending = {};
+    bool mHasPending = false;
+    bool mFinished = true;
+    std::uint32_t mTick = 0;
+    const std::uint8_t* mData = nullptr;
+    std::size_t mSize = 0;
+};
+
+#endif // REPLAY_H
@@ -0,0 +1,33 @@
+#ifndef SAVED_GAME_H
+#define SAVED_GAME_H
+
+#include <cstddef>
+#include <cstdint>
+
+// A saved game, as written by BasicSimulation::saveState: an 8-byte header
+// (magic, version, board width and height), then
+//   8  seed (8)                  16 RNG state (8)
+//   24 fall time (4, float)      28 time since the last fall (4, float)
+//   32 score (4)                 36 level (4)
+//   40 lines cleared (4)         44 points to the next level (4)
+//   48 lives (4)                 52 pieces spawned (4)
+//   56 game over (1)             57 falling piece type (1)
+//   58 falling piece rotation (1) 59 next piece type (1)
+//   60 falling piece x (2)       62 falling piece y (2)
+// and the board, two 4-bit color ids per byte, low nibble first, row by row.
+// All fields are little-endian. A standard game is 164 bytes, and loading it
+// continues the game exactly, pieces included.
+namespace SavedGameFormat {
+
+constexpr char MAGIC[4] = {'T', 'S', 'A', 'V'};
+constexpr std::uint16_t VERSION = 1;
+constexpr std::size_t HEADER_SIZE = 8;
+constexpr std::size_t FIELDS_SIZE = 56; // Between the header and the board
+
+constexpr std::size_t size(int width, int height) {
+    return HEADER_SIZE + FIELDS_SIZE + static_cast<std::size_t>(width * height + 1) / 2;
+}
+
+} // namespace SavedGameFormat
+
+#endif // SAVED_GAME_H
@@ -0,0 +1,102 @@
+#ifndef SCORE_STORE_H
+#define SCORE_STORE_H
+
+#include <array>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Stats of one finished game
+struct GameRecord {
+    std::int32_t score;
+    std::int32_t level;
+    std::int32_t lines;
+    std::uint32_t durationMs;
+    std::uint64_t seed;
+    std::int64_t endedAt; // Unix time, in seconds
+};
+
+// The score file is an 8-byte header followed by CRC-checked frames: one
+// summary frame (totals and the leaderboard), then one frame per game, oldest
+// first. Games are appended as they finish. Compaction folds the appended
+// games into a new summary and atomically replaces the file, so opening it
+// only reads the summary plus the games since the last compaction, and a
+// torn append is detected and dropped. All fields are little-endian.
+namespace ScoreFormat {
+
+constexpr char MAGIC[4] = {'T', 'S', 'C', 'R'};
+constexpr std::uint16_t VERSION = 1;
+constexpr std::size_t HEADER_SIZE = 8;       // Magic, version, 2 reserved
+constexpr std::size_t FRAME_OVERHEAD = 9;    // Payload length u32, type u8, CRC-32 u32
+constexpr std::size_t GAME_SIZE = 32;        // Payload of a game frame
+constexpr std::size_t GAME_FRAME_SIZE = GAME_SIZE + FRAME_OVERHEAD;
+constexpr std::uint8_t SUMMARY_FRAME = 1;
+constexpr std::uint8_t GAME_FRAME = 2;
+
+} // namespace ScoreFormat
+
+// Leaderboard and lifetime stats, persisted by a background thread. The game
+// thread only updates memory; appends, fsyncs and compaction happen on the
+// worker, so a game over never waits for the disk.
+class ScoreStore {
+public:
+    static constexpr int LEADERBOARD_SIZE = 10;
+    static constexpr int COMPACT_AFTER = 64; // Appended games that trigger a compaction
+
+    struct Summary {
+        std::uint64_t totalGames = 0;
+        std::uint64_t totalLines = 0;
+        std::uint64_t totalDurationMs = 0;
+        std::array<GameRecord, LEADERBOARD_SIZE> leaderboard = {}; // Best score first
+        int leaderboardCount = 0;
+
+        void add(const GameRecord& record);
+        int getBestScore() const { return leaderboardCount > 0 ? leaderboard[0].score : 0; }
+    };
+
+    // Loads the summary from path. When the file does not exist yet, the best
+    // score from legacyPath (the old plain-text best_score.txt) is imported.
+    explicit ScoreStore(const std::string& path, const std::string& legacyPath = "");
+    ~ScoreStore(); // Writes the games still queued, then stops the worker
+
+    ScoreStore(const ScoreStore&) = delete;
+    ScoreStore& operator=(const ScoreStore&) = delete;
+
+    // Call submit() and getSummary() from one thread, usually the game's
+    void submit(const GameRecord& record); // Queues the game; never blocks on I/O
+    const Summary& getSummary() const { return mSummary; }
+    int getBestScore() const { return mSummary.getBestScore(); }
+
+    void flush(); // Blocks until every submitted game is on disk
+
+private:
+    void load(const std::string& legacyPath);
+    void workerLoop();
+    bool append(const std::vector<GameRecord>& records);
+    bool compact();
+
+    std::string mPath;
+    Summary mSummary; // Includes queued games
+
+    // Worker state: what the file on disk holds
+    Summary mDiskSummary;
+    std::uint64_t mRecordsStart; // Offset of the first game frame
+    std::uint64_t mValidEnd;     // End of the last complete frame, 0 if no file yet
+    int mAppendedGames;          // Game frames after the summary's compacted ones
+    bool mNeedsCompaction;
+
+    std::mutex mMutex;
+    std::condition_variable mWorkAvailable;
+    std::condition_variable mIdle;
+    std::vector<GameRecord> mQueue;
+    bool mBusy;
+    bool mStopping;
+    bool mFailing; // The last write failed; reported once until one succeeds
+    std::thread mWorker;
+};
+
+#endif // SCORE_STORE_H
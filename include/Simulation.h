@@ -0,0 +1,148 @@
+#ifndef SIMULATION_H
+#define SIMULATION_H
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+#include "Board.h"
+#include "Random.h"
+#include "Tetromino.h"
+
+// Final resting pose of a piece: its box's top-left corner and rotation
+struct Placement {
+    int x;
+    int y;
+    int rotation;
+};
+
+// What the last lock did, for exporters and bots watching a game
+struct LockResult {
+    int type;            // The piece that locked
+    int nextType;        // The preview shown while it fell
+    Placement placement; // Where it locked
+    int linesCleared;
+    int scoreDelta;
+    bool lostLife;       // Locked above the top row, or the next piece did not fit, so the
+                         // board was cleared or the game ended
+};
+
+// What the rules share across board sizes: inputs and scoring
+class SimulationBase {
+public:
+    // Replays store these as bytes, so new inputs go at the end
+    enum class Input { None, Left, Right, Down, Rotate, HardDrop };
+
+    static constexpr int POINTS_PER_LINE = 20;
+    static constexpr int POINTS_PER_LEVEL = 100;
+    static constexpr int START_LIVES = 3;
+
+    static std::uint64_t makeSeed(); // From std::random_device
+};
+
+// The game rules with no window, font or clock attached: the board, the
+// falling and next pieces, scoring, levels and lives. Time only moves forward
+// through step(), so the rules run at full speed in batch jobs and servers.
+template <int Width, int Height>
+class BasicSimulation : public SimulationBase {
+public:
+    using BoardType = BasicBoard<Width, Height>;
+
+    static constexpr int SPAWN_X = Width / 2 - 2;
+
+    BasicSimulation();                           // First game seeded from std::random_device
+    explicit BasicSimulation(std::uint64_t seed);
+
+    // Start a new game. The pieces of a game depend only on its seed, so a
+    // seed and the inputs applied at each step reproduce the game exactly.
+    void reset(std::uint64_t seed);
+    void reset(); // With a fresh seed from std::random_device
+
+    // Applies one player input, then advances gravity by dt seconds. Locks the
+    // piece when gravity can no longer move it down.
+    void step(Input input, float dt);
+    // Writes the falling piece into the board, clears full lines, scores them
+    // and spawns the next piece. Returns the number of lines cleared. A piece
+    // that locks with a cell above the top row (a lock-out), like a next piece
+    // that does not fit at the spawn point, costs a life.
+    int lock();
+    // Puts the falling piece at the given pose and locks it there, for bots
+    // that pick a final placement instead of steering the piece. Returns the
+    // lines cleared, or -1 if the pose overlaps the board or the rotation is
+    // out of range.
+    int place(const Placement& placement);
+    // Drops the falling piece straight down and locks it. Returns the number
+    // of lines cleared.
+    int hardDrop();
+
+    // Replaces the falling piece with the next one at the spawn point and draws
+    // a new next piece. lock() calls it; it does not check for game over.
+    void spawnTetromino();
+
+    bool move(int dx, int dy); // Moves the falling piece if it fits
+    bool rotate();             // Clockwise rotation with wall kicks
+    bool checkCollision(const Tetromino& tetromino, int offsetX, int offsetY) const;
+    int getDropDistance() const; // Rows the falling piece can still fall
+
+    const BoardType& getBoard() const { return mBoard; }
+    const Tetromino& getCurrentTetromino() const { return mCurrentTetromino; }
+    const Tetromino& getNextTetromino() const { return mNextTetromino; }
+    int getScore() const { return mScore; }
+    int getLevel() const { return mLevel; }
+    int getLives() const { return mLives; }
+    int getLinesCleared() const { return mLinesCleared; }
+    int getPieceCount() const { return mPieceCount; } // Pieces spawned so far
+    std::uint64_t getSeed() const { return mSeed; }
+    bool isGameOver() const { return mGameOver; }
+    // The most recent lock; getPieceCount() goes up by one with every lock
+    const LockResult& getLastLock() const { return mLastLock; }
+
+    // The whole game, RNG state included, in SavedGameFormat. Loading it
+    // continues the game exactly where it was saved. loadState leaves the game
+    // unchanged and returns false when the data is damaged or was saved from
+    // a board of another size.
+    void saveState(std::vector<std::uint8_t>& out) const; // Appends
+    bool loadState(const std::uint8_t* data, std::size_t size);
+
+private:
+    void updateLevel();
+
+    BoardType mBoard;
+    // Pieces are plain values, so spawning never touches the heap
+    Tetromino mCurrentTetromino{0, SPAWN_X, 0};
+    Tetromino mNextTetromino{0, 0, 0}; // Shown as the preview
+
+    std::uint64_t mSeed;
+    Random mRandom;
+
+    // Fall timer, in seconds
+    float mFallTime;
+    float mTimeSinceLastFall;
+
+    // Game stats
+    int mScore;
+    int mLevel;
+    int mLinesCleared;
+    int mPointsToNextLevel;
+    int mLives;
+    int mPieceCount;
+    bool mGameOver;
+    LockResult mLastLock;
+};
+
+// The standard game and the variant modes, instantiated in Simulation.cpp
+using Simulation = BasicSimulation<10, 20>;
+using WideSimulation = BasicSimulation<20, 20>;
+using TallSimulation = BasicSimulation<10, 40>;
+
+extern template class BasicSimulation<10, 20>;
+extern template class BasicSimulation<20, 20>;
+extern template class BasicSimulation<10, 40>;
+
+// A game is one plain value, so search and rollouts branch and rewind by
+// copying it (see UndoStack) rather than replaying from the seed
+static_assert(std::is_trivially_copyable<Simulation>::value, "Simulation must stay a plain value type");
+static_assert(std::is_trivially_copyable<WideSimulation>::value, "Simulation must stay a plain value type");
+static_assert(std::is_trivially_copyable<TallSimulation>::value, "Simulation must stay a plain value type");
+
+#endif // SIMULATION_H
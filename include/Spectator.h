@@ -0,0 +1,102 @@
+#ifndef SPECTATOR_H
+#define SPECTATOR_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "Simulation.h"
+
+// The spectator stream: an 8-byte header (magic, version, board width and
+// height), then messages of a type byte, a 16-bit payload length and the
+// payload. A KEYFRAME carries the whole visible game; a DELTA carries only
+// what changed since the previous message: the piece pose, the stats and the
+// rows whose cells differ. Board rows are packed two 4-bit color ids per
+// byte, low nibble first. All fields are little-endian.
+namespace SpectatorFormat {
+
+constexpr char MAGIC[4] = {'T', 'S', 'P', 'C'};
+constexpr std::uint16_t VERSION = 1;
+constexpr std::size_t STREAM_HEADER_SIZE = 8;
+constexpr std::size_t MESSAGE_HEADER_SIZE = 3;
+
+constexpr std::uint8_t KEYFRAME = 1;
+constexpr std::uint8_t DELTA = 2;
+
+// Keyframe flag: the state the previous messages built must equal this one.
+// Set on periodic keyframes; clear when a client joins, lagged or a new game
+// started.
+constexpr std::uint8_t KEYFRAME_CHECKPOINT = 1;
+
+// Delta flags: which optional sections follow
+constexpr std::uint8_t DELTA_PIECE = 1;
+constexpr std::uint8_t DELTA_STATS = 2;
+
+} // namespace SpectatorFormat
+
+// Everything a spectator sees of one game at one tick
+struct SpectatorSnapshot {
+    static constexpr int WIDTH = Simulation::BoardType::WIDTH;
+    static constexpr int HEIGHT = Simulation::BoardType::HEIGHT;
+
+    std::uint32_t tick = 0;
+    std::uint64_t seed = 0;
+    std::int32_t score = 0;
+    std::int32_t level = 0;
+    std::int32_t linesCleared = 0;
+    std::int32_t lives = 0;
+    bool gameOver = false;
+    std::uint8_t pieceType = 0;
+    std::uint8_t pieceRotation = 0;
+    std::int8_t pieceX = 0;
+    std::int8_t pieceY = 0;
+    std::uint8_t nextType = 0;
+    std::array<std::uint8_t, WIDTH * HEIGHT> cells = {}; // Color ids, as Board::getCell
+
+    static SpectatorSnapshot capture(const Simulation& simulation, std::uint32_t tick);
+
+    // Same game state; the tick is ignored, since deltas are only sent when
+    // something visible changed
+    bool operator==(const SpectatorSnapshot& other) const;
+    bool operator!=(const SpectatorSnapshot& other) const { return !(*this == other); }
+};
+
+namespace SpectatorFormat {
+
+void writeStreamHeader(std::vector<std::uint8_t>& out);
+// Append one message to out
+void writeKeyframe(const SpectatorSnapshot& snapshot, std::uint8_t flags, std::vector<std::uint8_t>& out);
+// Appends nothing and returns false when the snapshots look the same
+bool writeDelta(const SpectatorSnapshot& from, const SpectatorSnapshot& to, std::vector<std::uint8_t>& out);
+
+} // namespace SpectatorFormat
+
+// Rebuilds the game from a spectator stream, fed in whatever pieces the
+// socket delivers
+class SpectatorDecoder {
+public:
+    // Applies every complete message in the data. Returns false once the
+    // stream is malformed.
+    bool feed(const std::uint8_t* data, std::size_t size);
+
+    bool hasSnapshot() const { return mHasSnapshot; }
+    const SpectatorSnapshot& getSnapshot() const { return mSnapshot; }
+    long long getKeyframes() const { return mKeyframes; }
+    long long getDeltas() const { return mDeltas; }
+    // Checkpoint keyframes that disagreed with the state the deltas built
+    long long getMismatches() const { return mMismatches; }
+
+private:
+    bool decodeMessage(std::uint8_t type, const std::uint8_t* payload, std::size_t size);
+
+    std::vector<std::uint8_t> mPending; // Bytes of a message not yet complete
+    bool mHeaderRead = false;
+    bool mFailed = false;
+    bool mHasSnapshot = false;
+    SpectatorSnapshot mSnapshot;
+    long long mKeyframes = 0;
+    long long mDeltas = 0;
+    long long mMismatches = 0;
+};
+
+#endif // SPECTATOR_H
@@ -0,0 +1,61 @@
+#ifndef SPECTATOR_SERVER_H
+#define SPECTATOR_SERVER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "Spectator.h"
+
+// Streams a game to any number of local spectators over TCP (loopback only)
+// or a Unix socket, in the SpectatorFormat stream. Everything runs on the
+// caller's thread with non-blocking sockets: publish() accepts new clients,
+// queues a message per client and makes one write attempt each, so a slow or
+// stalled spectator never holds up the game. A spectator whose backlog grows
+// past MAX_BACKLOG stops receiving deltas and is resynchronized with a
+// keyframe once it catches up. Sockets are only available on POSIX systems;
+// elsewhere listening fails.
+class SpectatorServer {
+public:
+    static constexpr int KEYFRAME_INTERVAL = 60;          // Publishes between checkpoint keyframes
+    static constexpr std::size_t MAX_BACKLOG = 64 * 1024; // Unsent bytes per client before it is skipped
+
+    SpectatorServer() = default;
+    ~SpectatorServer();
+
+    SpectatorServer(const SpectatorServer&) = delete;
+    SpectatorServer& operator=(const SpectatorServer&) = delete;
+
+    bool listenTcp(std::uint16_t port); // On 127.0.0.1
+    bool listenUnix(const std::string& path); // Replaces a stale socket file
+    bool isListening() const { return !mListeners.empty(); }
+    void close();
+
+    // Sends the game's state as of this call. Never blocks.
+    void publish(const SpectatorSnapshot& snapshot);
+
+    std::size_t getClientCount() const { return mClients.size(); }
+
+private:
+    struct Client {
+        int fd;
+        std::vector<std::uint8_t> pending; // Queued bytes, sent from offset on
+        std::size_t offset;
+        bool needsKeyframe; // Just joined, or skipped deltas while lagging
+    };
+
+    void acceptClients();
+    bool flush(Client& client); // False once the client is gone
+
+    std::vector<int> mListeners;
+    std::string mUnixPath; // Removed on close
+    std::vector<Client> mClients;
+
+    SpectatorSnapshot mLast;
+    bool mHasLast = false;
+    int mSinceKeyframe = 0;
+    std::vector<std::uint8_t> mDelta;    // Encoded once per publish, shared by all clients
+    std::vector<std::uint8_t> mKeyframe;
+};
+
+#endif // SPECTATOR_SERVER_H
@@ -0,0 +1,53 @@
+#ifndef TERMINAL_SCREEN_H
+#define TERMINAL_SCREEN_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "Tetromino.h"
+
+// A character grid for ANSI terminals. Each frame is drawn in full into the
+// back buffer, and present() emits escape sequences for only the cells that
+// differ from what the terminal already shows, so an unchanged frame costs
+// no output at all. Colors are xterm 256-color palette indices.
+class TerminalScreen {
+public:
+    static constexpr std::int16_t DEFAULT_COLOR = -1; // The terminal's own color
+
+    TerminalScreen(int columns, int rows);
+
+    int getColumns() const { return mColumns; }
+    int getRows() const { return mRows; }
+
+    void clear(); // Blanks the back buffer
+    void put(int x, int y, char ch, std::int16_t fg = DEFAULT_COLOR, std::int16_t bg = DEFAULT_COLOR);
+    void text(int x, int y, const char* str, std::int16_t fg = DEFAULT_COLOR);
+
+    // Appends to out the sequences that turn the shown frame into the back
+    // buffer. Out is not cleared, so a caller can reuse one string per frame.
+    void present(std::string& out);
+    // Forgets what the terminal shows, so the next present() redraws every
+    // cell. Needed after a resize or anything else that scribbled on it.
+    void invalidate();
+
+    // Nearest color of the 6x6x6 cube in the xterm palette
+    static std::int16_t toPaletteColor(const Rgb& rgb);
+
+private:
+    struct Cell {
+        char ch;
+        std::int16_t fg;
+        std::int16_t bg;
+
+        bool operator==(const Cell& other) const { return ch == other.ch && fg == other.fg && bg == other.bg; }
+        bool operator!=(const Cell& other) const { return !(*this == other); }
+    };
+
+    int mColumns;
+    int mRows;
+    std::vector<Cell> mBack;  // Frame being drawn
+    std::vector<Cell> mShown; // What the terminal shows
+    bool mShownValid;
+};
+
+#endif // TERMINAL_SCREEN_H
@@ -1,33 +1,147 @@
 #ifndef TETROMINO_H
 #define TETROMINO_H
 
-#include <SFML/Graphics.hpp>
-#include <vector>
-#include <algorithm> // For std::min and std::max (not directly used here, but good practice for vector manipulation)
+#include <array>
+#include <cstdint>
+#include <type_traits>
+#include "Board.h"
+
+// A grid position or offset, in cells. Block offsets are relative to the
+// top-left corner of their piece's box.
+struct Cell {
+    int x;
+    int y;
+};
+
+// One rotation state of a piece: its blocks, the same blocks packed as Board
+// row masks, their bounding box (inclusive) and the lowest block per column.
+struct Orientation {
+    std::array<Cell, 4> cells;
+    PieceRows rows;
+    Cell min;
+    Cell max;
+    PieceBottoms bottoms;
+};
+
+namespace TetrominoTables {
+
+constexpr int TYPE_COUNT = 7;
+constexpr int ROTATION_COUNT = 4;
+constexpr int KICK_COUNT = 5;
+
+using OrientationTable = std::array<std::array<Orientation, ROTATION_COUNT>, TYPE_COUNT>;
+using KickTable = std::array<std::array<std::array<Cell, KICK_COUNT>, ROTATION_COUNT>, TYPE_COUNT>;
+
+// Spawn orientation of each piece and the side of the square box it rotates in
+constexpr std::array<std::array<Cell, 4>, TYPE_COUNT> BASE_SHAPES = {{
+    {{{0,0}, {1,0}, {0,1}, {1,1}}}, // O
+    {{{0,1}, {1,1}, {2,1}, {3,1}}}, // I, in row 1 so it turns about the SRS center
+    {{{0,1}, {1,1}, {2,1}, {1,0}}}, // T
+    {{{0,0}, {0,1}, {1,1}, {2,1}}}, // L
+    {{{2,0}, {0,1}, {1,1}, {2,1}}}, // J
+    {{{1,0}, {2,0}, {0,1}, {1,1}}}, // S
+    {{{0,0}, {1,0}, {1,1}, {2,1}}}  // Z
+}};
+constexpr std::array<int, TYPE_COUNT> BOX_SIZES = {2, 4, 3, 3, 3, 3, 3};
+
+constexpr Orientation makeOrientation(const std::array<Cell, 4>& cells) {
+    Orientation orientation = {cells, {}, cells[0], cells[0], {{-1, -1, -1, -1}}};
+    for (const Cell& c : cells) {
+        orientation.bottoms[c.x] = static_cast<std::int8_t>(c.y > orientation.bottoms[c.x] ? c.y : orientation.bottoms[c.x]);
+        orientation.rows[c.y] = static_cast<std::uint8_t>(orientation.rows[c.y] | (1u << c.x));
+        orientation.min.x = c.x < orientation.min.x ? c.x : orientation.min.x;
+        orientation.min.y = c.y < orientation.min.y ? c.y : orientation.min.y;
+        orientation.max.x = c.x > orientation.max.x ? c.x : orientation.max.x;
+        orientation.max.y = c.y > orientation.max.y ? c.y : orientation.max.y;
+    }
+    return orientation;
+}
+
+// Rotates every piece clockwise inside its box, so rotation never drifts
+constexpr OrientationTable makeOrientations() {
+    OrientationTable table = {};
+    for (int type = 0; type < TYPE_COUNT; ++type) {
+        std::array<Cell, 4> cells = BASE_SHAPES[type];
+        for (int rotation = 0; rotation < ROTATION_COUNT; ++rotation) {
+            table[type][rotation] = makeOrientation(cells);
+            for (Cell& c : cells) {
+                c = Cell{BOX_SIZES[type] - 1 - c.y, c.x};
+            }
+        }
+    }
+    return table;
+}
+
+// SRS clockwise wall kicks, indexed by the rotation being left. y grows downwards.
+constexpr std::array<std::array<Cell, KICK_COUNT>, ROTATION_COUNT> JLSTZ_KICKS = {{
+    {{{0,0}, {-1,0}, {-1,-1}, {0, 2}, {-1, 2}}},
+    {{{0,0}, { 1,0}, { 1, 1}, {0,-2}, { 1,-2}}},
+    {{{0,0}, { 1,0}, { 1,-1}, {0, 2}, { 1, 2}}},
+    {{{0,0}, {-1,0}, {-1, 1}, {0,-2}, {-1,-2}}}
+}};
+constexpr std::array<std::array<Cell, KICK_COUNT>, ROTATION_COUNT> I_KICKS = {{
+    {{{0,0}, {-2,0}, { 1,0}, {-2, 1}, { 1,-2}}},
+    {{{0,0}, {-1,0}, { 2,0}, {-1,-2}, { 2, 1}}},
+    {{{0,0}, { 2,0}, {-1,0}, { 2,-1}, {-1, 2}}},
+    {{{0,0}, { 1,0}, {-2,0}, { 1, 2}, {-2,-1}}}
+}};
+
+constexpr KickTable makeKicks() {
+    KickTable table = {}; // The O piece never needs a kick
+    for (int type = 1; type < TYPE_COUNT; ++type) {
+        table[type] = (type == 1) ? I_KICKS : JLSTZ_KICKS;
+    }
+    return table;
+}
+
+} // namespace TetrominoTables
+
+// Piece colors, kept free of any graphics library so every front end can map
+// them to its own color type
+struct Rgb {
+    std::uint8_t r;
+    std::uint8_t g;
+    std::uint8_t b;
+};
 
 class Tetromino {
 public:
+    static constexpr int ROTATION_COUNT = TetrominoTables::ROTATION_COUNT;
+
     Tetromino(int type, int x, int y);
 
     void move(int dx, int dy);
-    std::vector<sf::Vector2i> getRotatedShape() const; // Changed from rotate()
+    void setRotation(int rotation) { mRotation = rotation; }
+    static int nextRotation(int rotation) { return (rotation + 1) % ROTATION_COUNT; }
 
-    void draw(sf::RenderWindow& window, int cellSize, const sf::Vector2i& offset = sf::Vector2i(0, 0)) const;
-
-    sf::Vector2i getPosition() const;
-    const std::vector<sf::Vector2i>& getShape() const;
-    void setShape(const std::vector<sf::Vector2i>& newShape); // New setter for shape
+    Cell getPosition() const;
     int getType() const { return mType; }
+    int getRotation() const { return mRotation; }
+    const Orientation& getOrientation() const { return SHAPES[mType][mRotation]; }
+    const std::array<Cell, 4>& getShape() const { return getOrientation().cells; }
+    // Offsets to try, in order, when rotating clockwise from the current state
+    const std::array<Cell, TetrominoTables::KICK_COUNT>& getKicks() const { return KICKS[mType][mRotation]; }
 
-public: // Made public for direct access from Game::spawnTetromino
-    static const std::vector<std::vector<sf::Vector2i>> SHAPES;
-    static const std::vector<sf::Color> COLORS;
+public: // Made public for direct access from the simulation and renderers
+    static constexpr TetrominoTables::OrientationTable SHAPES = TetrominoTables::makeOrientations();
+    static constexpr TetrominoTables::KickTable KICKS = TetrominoTables::makeKicks();
+    static constexpr std::array<Rgb, TetrominoTables::TYPE_COUNT> COLORS = {{
+        {255, 255, 0},  // Yellow
+        {0, 255, 255},  // Cyan
+        {255, 0, 255},  // Magenta
+        {255, 165, 0},  // Orange
+        {0, 0, 255},    // Blue
+        {0, 255, 0},    // Green
+        {255, 0, 0}     // Red
+    }};
 
 private:
     int mType;
-    sf::Vector2i mPosition;
-    std::vector<sf::Vector2i> mShape;
-    sf::Color mColor;
+    int mRotation;
+    Cell mPosition;
 };
 
+// Pieces are copied on every move, rotation and spawn
+static_assert(std::is_trivially_copyable<Tetromino>::value, "Tetromino must stay a plain value type");
+
 #endif // TETROMINO_H
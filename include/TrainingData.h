@@ -0,0 +1,114 @@
+#ifndef TRAINING_DATA_H
+#define TRAINING_DATA_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "Simulation.h"
+
+// Training data: one row per locked piece, stored column by column so a
+// column can be memory-mapped as a plain array (numpy.memmap, say).
+//
+// The file starts with a HEADER_SIZE-byte header: magic, version (2), column
+// count (2), rows per chunk (4), board width and height (1 each), 2 reserved,
+// row count (8), game count (8), chunk size in bytes (8), 24 reserved, then
+// one 32-byte entry per column: a zero-padded name (16), the value width in
+// bytes (4), the column's offset inside a chunk (4) and 8 reserved. The
+// header is rewritten after every chunk, so a file cut short by a crash
+// still describes its complete chunks.
+//
+// Chunk i starts at HEADER_SIZE + i * CHUNK_BYTES and holds CHUNK_ROWS rows:
+// column c is CHUNK_ROWS values of its width at the column's offset. Rows
+// past the row count in the last chunk are zero. All values are
+// little-endian.
+namespace TrainingDataFormat {
+
+constexpr char MAGIC[4] = {'T', 'T', 'R', 'N'};
+constexpr std::uint16_t VERSION = 1;
+constexpr std::size_t HEADER_SIZE = 4096;
+constexpr std::size_t CHUNK_ROWS = 65536;
+constexpr std::size_t BOARD_BYTES = (Board::WIDTH * Board::HEIGHT + 7) / 8;
+
+struct Column {
+    const char* name;
+    std::size_t width;
+};
+
+// Occupancy before the lock, cell (x, y) at bit y * WIDTH + x; the piece
+// type (0-6) that locked and the one in the preview; its final pose, with x
+// and y as signed bytes; lines cleared and score gained by the lock; 1 when
+// the stack reached the spawn point; the game, numbered in the order games
+// were appended, and its seed
+constexpr std::array<Column, 11> COLUMNS = {{
+    {"board", BOARD_BYTES}, {"piece", 1}, {"next", 1}, {"x", 1}, {"y", 1}, {"rotation", 1},
+    {"lines", 1}, {"score_delta", 4}, {"lost_life", 1}, {"game", 4}, {"seed", 8}
+}};
+
+constexpr std::size_t rowBytes() {
+    std::size_t bytes = 0;
+    for (const Column& column : COLUMNS) {
+        bytes += column.width;
+    }
+    return bytes;
+}
+
+constexpr std::size_t CHUNK_BYTES = CHUNK_ROWS * rowBytes();
+
+static_assert(HEADER_SIZE >= 64 + 32 * COLUMNS.size(), "Column table does not fit the header");
+
+} // namespace TrainingDataFormat
+
+// One decision: the board a piece fell onto and what its lock did
+struct TrainingRecord {
+    std::array<std::uint8_t, TrainingDataFormat::BOARD_BYTES> board;
+    LockResult lock;
+
+    static TrainingRecord make(const Board& before, const LockResult& lock);
+};
+
+// Appends records to a training data file. Each chunk is mapped into memory
+// while it fills, so rows are plain stores; the file only grows, and the
+// header is only written, once per chunk. Where mmap is unavailable a chunk
+// is filled in memory and written out in one call instead. append() may be
+// called from any thread.
+class TrainingDataWriter {
+public:
+    TrainingDataWriter() = default;
+    ~TrainingDataWriter();
+
+    TrainingDataWriter(const TrainingDataWriter&) = delete;
+    TrainingDataWriter& operator=(const TrainingDataWriter&) = delete;
+
+    bool open(const std::string& path); // Replaces the file
+    // Adds one game's decisions as a batch, under one game number
+    bool append(const TrainingRecord* records, std::size_t count, std::uint64_t seed);
+    bool close(); // Writes the final header. False if any write failed.
+
+    std::uint64_t getRowCount() const { return mRowCount; }
+    std::uint64_t getGameCount() const { return mGameCount; }
+
+private:
+    bool beginChunk(); // Grows the file by a chunk and maps it, from the page it starts in
+    bool endChunk();   // Unmaps the full chunk and rewrites the header
+    bool writeHeader();
+    void writeRow(std::size_t row, const TrainingRecord& record, std::uint32_t game, std::uint64_t seed);
+
+    std::mutex mMutex;
+    int mFd = -1;                       // When chunks are mapped
+    std::fstream mFile;                 // Otherwise
+    std::uint8_t* mChunk = nullptr;     // The chunk being filled
+    void* mMapping = nullptr;           // Where its mapping starts, up to a page before it
+    std::size_t mMappingSize = 0;
+    std::vector<std::uint8_t> mBuffer;  // Holds it when the file cannot be mapped
+    std::uint64_t mChunkIndex = 0;
+    std::size_t mChunkRows = 0;         // Rows in the current chunk
+    std::uint64_t mRowCount = 0;
+    std::uint64_t mGameCount = 0;
+    bool mFailed = false;
+};
+
+#endif // TRAINING_DATA_H
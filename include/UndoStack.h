@@ -0,0 +1,60 @@
+#ifndef UNDO_STACK_H
+#define UNDO_STACK_H
+
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <type_traits>
+
+// Saved copies of a plain value, such as a Simulation, for search and
+// rollouts to branch from and rewind to. push() and pop() are one memcpy
+// each, and all slots are allocated up front. When the stack is full, a push
+// drops the oldest entry, so it keeps the most recent history.
+template <typename State>
+class UndoStack {
+    static_assert(std::is_trivially_copyable<State>::value, "States are saved and restored by memcpy");
+
+public:
+    explicit UndoStack(std::size_t capacity)
+        : mCapacity(capacity > 0 ? capacity : 1), mSlots(new Slot[mCapacity]) {}
+
+    void push(const State& state) {
+        std::memcpy(mSlots[mTop].bytes, &state, sizeof(State));
+        mTop = (mTop + 1 == mCapacity) ? 0 : mTop + 1;
+        if (mSize < mCapacity) {
+            mSize++;
+        }
+    }
+
+    // Restores the most recently pushed state. Returns false when empty.
+    bool pop(State& state) {
+        if (mSize == 0) {
+            return false;
+        }
+        mTop = (mTop == 0 ? mCapacity : mTop) - 1;
+        mSize--;
+        std::memcpy(&state, mSlots[mTop].bytes, sizeof(State));
+        return true;
+    }
+
+    void clear() {
+        mTop = 0;
+        mSize = 0;
+    }
+
+    bool isEmpty() const { return mSize == 0; }
+    std::size_t getSize() const { return mSize; }
+    std::size_t getCapacity() const { return mCapacity; }
+
+private:
+    struct Slot {
+        alignas(State) unsigned char bytes[sizeof(State)];
+    };
+
+    std::size_t mCapacity;
+    std::unique_ptr<Slot[]> mSlots;
+    std::size_t mTop = 0; // Slot the next push writes
+    std::size_t mSize = 0;
+};
+
+#endif // UNDO_STACK_H
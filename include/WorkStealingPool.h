@@ -0,0 +1,53 @@
+#ifndef WORK_STEALING_POOL_H
+#define WORK_STEALING_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of worker threads, each with its own task deque. A worker runs
+// tasks from the back of its own deque and, when that is empty, steals from
+// the front of the others', so uneven task lengths still keep every core busy.
+class WorkStealingPool {
+public:
+    explicit WorkStealingPool(unsigned threadCount = std::thread::hardware_concurrency());
+    ~WorkStealingPool();
+
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+    // Queues a task. Tasks submitted from a worker go to that worker's deque,
+    // others are spread round-robin.
+    void submit(std::function<void()> task);
+    // Blocks until every submitted task has finished
+    void wait();
+
+    unsigned getThreadCount() const { return static_cast<unsigned>(mThreads.size()); }
+
+private:
+    struct Worker {
+        std::mutex mutex;
+        std::deque<std::function<void()>> tasks;
+    };
+
+    void workerLoop(unsigned index);
+    bool popTask(unsigned index, std::function<void()>& task);
+
+    std::vector<std::unique_ptr<Worker>> mWorkers;
+    std::vector<std::thread> mThreads;
+    std::atomic<unsigned> mNextWorker;
+    std::atomic<long> mQueued;  // Tasks sitting in a deque
+    std::atomic<long> mPending; // Tasks submitted but not finished
+
+    std::mutex mStateMutex;
+    std::condition_variable mWorkAvailable;
+    std::condition_variable mAllDone;
+    bool mStopping;
+};
+
+#endif // WORK_STEALING_POOL_H
@@ -0,0 +1,151 @@
+#include "Board.h"
+#include <algorithm>
+
+template <int Width, int Height>
+BasicBoard<Width, Height>::BasicBoard() {
+    clear();
+}
+
+template <int Width, int Height>
+void BasicBoard<Width, Height>::clear() {
+    std::fill(mRows.begin(), mRows.begin() + TOP_ROWS + HEIGHT, EMPTY_ROW);
+    std::fill(mRows.begin() + TOP_ROWS + HEIGHT, mRows.end(), FULL_ROW);
+    mColors.fill(0);
+    mSurface.fill(static_cast<std::uint8_t>(HEIGHT));
+}
+
+template <int Width, int Height>
+bool BasicBoard<Width, Height>::collides(const PieceRows& piece, int x, int y) const {
+    // Every piece cell lies inside its box, so a box entirely past a wall or
+    // below the floor rows always collides.
+    if (x < -PADDING || x >= WIDTH || y > HEIGHT) {
+        return true;
+    }
+
+    const int shift = x + PADDING;
+    Row hits = 0;
+    for (int r = 0; r < 4; ++r) {
+        int index = y + r + TOP_ROWS;
+        Row row = (index >= 0) ? mRows[index] : EMPTY_ROW;
+        hits |= row & static_cast<Row>(static_cast<Row>(piece[r]) << shift);
+    }
+    return hits != 0;
+}
+
+template <int Width, int Height>
+void BasicBoard<Width, Height>::place(const PieceRows& piece, int x, int y, int color) {
+    for (int r = 0; r < 4; ++r) {
+        int gridY = y + r;
+        if (piece[r] == 0 || gridY < 0 || gridY >= HEIGHT) {
+            continue;
+        }
+        mRows[gridY + TOP_ROWS] |= static_cast<Row>(static_cast<Row>(piece[r]) << (x + PADDING));
+        for (int c = 0; c < 4; ++c) {
+            if (piece[r] & (1u << c)) {
+                mColors[gridY * WIDTH + x + c] = static_cast<std::uint8_t>(color);
+                mSurface[x + c] = std::min(mSurface[x + c], static_cast<std::uint8_t>(gridY));
+            }
+        }
+    }
+}
+
+template <int Width, int Height>
+int BasicBoard<Width, Height>::clearFullLines() {
+    int linesCleared = 0;
+    int writeY = HEIGHT - 1;
+    for (int readY = HEIGHT - 1; readY >= 0; --readY) {
+        Row row = mRows[readY + TOP_ROWS];
+        if (row == FULL_ROW) {
+            linesCleared++;
+            continue;
+        }
+        if (writeY != readY) {
+            mRows[writeY + TOP_ROWS] = row;
+            std::copy_n(mColors.begin() + readY * WIDTH, WIDTH, mColors.begin() + writeY * WIDTH);
+        }
+        writeY--;
+    }
+
+    // Refill the rows vacated at the top
+    for (; writeY >= 0; --writeY) {
+        mRows[writeY + TOP_ROWS] = EMPTY_ROW;
+        std::fill_n(mColors.begin() + writeY * WIDTH, WIDTH, 0);
+    }
+
+    // Rows only move down, so no surface can have risen above the old top
+    if (linesCleared > 0) {
+        rebuildSurface(*std::min_element(mSurface.begin(), mSurface.end()));
+    }
+    return linesCleared;
+}
+
+template <int Width, int Height>
+void BasicBoard<Width, Height>::setCells(const std::uint8_t* colors) {
+    std::copy_n(colors, WIDTH * HEIGHT, mColors.begin());
+    for (int y = 0; y < HEIGHT; ++y) {
+        Row row = EMPTY_ROW;
+        for (int x = 0; x < WIDTH; ++x) {
+            Row occupied = colors[y * WIDTH + x] != 0 ? 1 : 0;
+            row = static_cast<Row>(row | static_cast<Row>(occupied << (x + PADDING)));
+        }
+        mRows[y + TOP_ROWS] = row;
+    }
+    rebuildSurface(0);
+}
+
+template <int Width, int Height>
+void BasicBoard<Width, Height>::rebuildSurface(int fromY) {
+    mSurface.fill(static_cast<std::uint8_t>(HEIGHT));
+    Row remaining = static_cast<Row>((static_cast<Row>(1) << WIDTH) - 1); // Columns whose top is not found yet
+    for (int y = fromY; y < HEIGHT && remaining; ++y) {
+        Row found = getRow(y) & remaining;
+        remaining = static_cast<Row>(remaining & ~found);
+        for (int x = 0; found; ++x, found = static_cast<Row>(found >> 1)) {
+            if (found & 1u) {
+                mSurface[x] = static_cast<std::uint8_t>(y);
+            }
+        }
+    }
+}
+
+template <int Width, int Height>
+int BasicBoard<Width, Height>::dropDistance(const PieceRows& piece, const PieceBottoms& bottoms, int x, int y) const {
+    int distance = -1;
+    for (int c = 0; c < 4; ++c) {
+        if (bottoms[c] < 0) {
+            continue;
+        }
+        int gap = mSurface[x + c] - (y + bottoms[c]) - 1;
+        if (gap < 0) {
+            // A block is below the top of its column: probe row by row
+            distance = 0;
+            while (!collides(piece, x, y + distance + 1)) {
+                distance++;
+            }
+            return distance;
+        }
+        if (distance < 0 || gap < distance) {
+            distance = gap;
+        }
+    }
+    return distance;
+}
+
+template <int Width, int Height>
+bool BasicBoard<Width, Height>::isOccupied(int x, int y) const {
+    return (getRow(y) >> x) & 1u;
+}
+
+template <int Width, int Height>
+int BasicBoard<Width, Height>::getCell(int x, int y) const {
+    return mColors[y * WIDTH + x];
+}
+
+template <int Width, int Height>
+typename BasicBoard<Width, Height>::Row BasicBoard<Width, Height>::getRow(int y) const {
+    return static_cast<Row>((mRows[y + TOP_ROWS] & PLAYFIELD_MASK) >> PADDING);
+}
+
+template class BasicBoard<10, 20>;
+template class BasicBoard<20, 20>;
+template class BasicBoard<10, 40>;
@@ -0,0 +1,232 @@
+#include "BoardBatch.h"
+#include <algorithm>
+#include "Random.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define TETRIS_HAS_SSE2 1
+#endif
+
+namespace {
+
+// Each orientation's four 4-bit rows packed into the 16-bit lanes of one word,
+// so a collision test is a single AND against four board rows
+using PieceMaskTable = std::array<std::array<std::uint64_t, TetrominoTables::ROTATION_COUNT>, TetrominoTables::TYPE_COUNT>;
+
+constexpr PieceMaskTable makePieceMasks() {
+    PieceMaskTable table = {};
+    for (int type = 0; type < TetrominoTables::TYPE_COUNT; ++type) {
+        for (int rotation = 0; rotation < TetrominoTables::ROTATION_COUNT; ++rotation) {
+            const Board::PieceRows& rows = Tetromino::SHAPES[type][rotation].rows;
+            for (int r = 0; r < 4; ++r) {
+                table[type][rotation] |= static_cast<std::uint64_t>(rows[r]) << (16 * r);
+            }
+        }
+    }
+    return table;
+}
+
+constexpr PieceMaskTable PIECE_MASKS = makePieceMasks();
+
+// Four consecutive rows as one word; compiles to a single load on
+// little-endian targets
+std::uint64_t loadRows(const Board::Row* rows) {
+    return static_cast<std::uint64_t>(rows[0]) | static_cast<std::uint64_t>(rows[1]) << 16 |
+           static_cast<std::uint64_t>(rows[2]) << 32 | static_cast<std::uint64_t>(rows[3]) << 48;
+}
+
+int popCount(std::uint32_t bits) {
+    int count = 0;
+    for (; bits; bits &= bits - 1) {
+        count++;
+    }
+    return count;
+}
+
+} // namespace
+
+BoardBatch::BoardBatch(std::size_t size)
+    : mSize(size),
+      mRowStorage(size * ROW_STRIDE + ROW_STRIDE),
+      mType(size),
+      mRotation(size),
+      mX(size),
+      mY(size),
+      mNextType(size),
+      mRandomState(size),
+      mScore(size),
+      mLinesCleared(size),
+      mPieceCount(size),
+      mLives(size),
+      mGameOver(size)
+{
+    // Start every board on a cache line boundary
+    std::uintptr_t address = reinterpret_cast<std::uintptr_t>(mRowStorage.data());
+    std::uintptr_t misalignment = address % (ROW_STRIDE * sizeof(Board::Row));
+    mRows = mRowStorage.data() + (misalignment ? (ROW_STRIDE * sizeof(Board::Row) - misalignment) / sizeof(Board::Row) : 0);
+    resetAll(0);
+}
+
+void BoardBatch::reset(std::size_t board, std::uint64_t seed) {
+    clearBoard(board);
+    Random random(seed);
+    mType[board] = static_cast<std::uint8_t>(random.nextInt(TetrominoTables::TYPE_COUNT));
+    mNextType[board] = static_cast<std::uint8_t>(random.nextInt(TetrominoTables::TYPE_COUNT));
+    mRandomState[board] = random.getState();
+    mRotation[board] = 0;
+    mX[board] = Simulation::SPAWN_X;
+    mY[board] = 0;
+    mScore[board] = 0;
+    mLinesCleared[board] = 0;
+    mPieceCount[board] = 1;
+    mLives[board] = Simulation::START_LIVES;
+    mGameOver[board] = 0;
+}
+
+void BoardBatch::resetAll(std::uint64_t firstSeed) {
+    for (std::size_t board = 0; board < mSize; ++board) {
+        reset(board, firstSeed + board);
+    }
+}
+
+void BoardBatch::clearBoard(std::size_t board) {
+    Board::Row* boardRows = rows(board);
+    std::fill(boardRows, boardRows + TOP_ROWS + HEIGHT, EMPTY_ROW);
+    std::fill(boardRows + TOP_ROWS + HEIGHT, boardRows + ROW_STRIDE, FULL_ROW);
+}
+
+std::size_t BoardBatch::stepGravity() {
+    std::size_t running = 0;
+    for (std::size_t board = 0; board < mSize; ++board) {
+        if (mGameOver[board]) {
+            continue;
+        }
+        if (collides(board, mType[board], mRotation[board], mX[board], mY[board] + 1)) {
+            lock(board);
+        } else {
+            mY[board]++;
+        }
+        running += !mGameOver[board];
+    }
+    return running;
+}
+
+int BoardBatch::place(std::size_t board, const Placement& placement) {
+    if (placement.rotation < 0 || placement.rotation >= Tetromino::ROTATION_COUNT ||
+        collides(board, mType[board], placement.rotation, placement.x, placement.y)) {
+        return -1;
+    }
+    mRotation[board] = static_cast<std::uint8_t>(placement.rotation);
+    mX[board] = static_cast<std::int8_t>(placement.x);
+    mY[board] = static_cast<std::int8_t>(placement.y);
+    return lock(board);
+}
+
+bool BoardBatch::collides(std::size_t board, int type, int rotation, int x, int y) const {
+    if (x < -PADDING || x >= WIDTH || y > HEIGHT) {
+        return true;
+    }
+
+    std::uint64_t piece = PIECE_MASKS[type][rotation] << (x + PADDING);
+    std::uint64_t boardRows;
+    if (y >= -TOP_ROWS) {
+        boardRows = loadRows(rows(board) + y + TOP_ROWS);
+    } else {
+        // Rows above the stored ones only hold the walls
+        Board::Row padded[4];
+        for (int r = 0; r < 4; ++r) {
+            int index = y + r + TOP_ROWS;
+            padded[r] = index >= 0 ? rows(board)[index] : EMPTY_ROW;
+        }
+        boardRows = loadRows(padded);
+    }
+    return (boardRows & piece) != 0;
+}
+
+int BoardBatch::clearFullLines(std::size_t board) {
+    Board::Row* boardRows = rows(board);
+
+    // Bit y of full is set when row index y is full
+#ifdef TETRIS_HAS_SSE2
+    const __m128i fullRow = _mm_set1_epi16(-1);
+    const __m128i* vectors = reinterpret_cast<const __m128i*>(boardRows);
+    __m128i low = _mm_packs_epi16(_mm_cmpeq_epi16(_mm_load_si128(vectors), fullRow),
+                                  _mm_cmpeq_epi16(_mm_load_si128(vectors + 1), fullRow));
+    __m128i high = _mm_packs_epi16(_mm_cmpeq_epi16(_mm_load_si128(vectors + 2), fullRow),
+                                   _mm_cmpeq_epi16(_mm_load_si128(vectors + 3), fullRow));
+    std::uint32_t full = static_cast<std::uint32_t>(_mm_movemask_epi8(low)) |
+                         static_cast<std::uint32_t>(_mm_movemask_epi8(high)) << 16;
+#else
+    std::uint32_t full = 0;
+    for (int y = 0; y < ROW_STRIDE; ++y) {
+        full |= static_cast<std::uint32_t>(boardRows[y] == FULL_ROW) << y;
+    }
+#endif
+    full = (full >> TOP_ROWS) & ((1u << HEIGHT) - 1);
+    if (full == 0) {
+        return 0;
+    }
+
+    // Compact the remaining rows downwards, then refill the top
+    Board::Row* grid = boardRows + TOP_ROWS;
+    int writeY = HEIGHT - 1;
+    for (int readY = HEIGHT - 1; readY >= 0; --readY) {
+        if (!((full >> readY) & 1u)) {
+            grid[writeY--] = grid[readY];
+        }
+    }
+    for (; writeY >= 0; --writeY) {
+        grid[writeY] = EMPTY_ROW;
+    }
+    return popCount(full);
+}
+
+int BoardBatch::lock(std::size_t board) {
+    // Write the piece into the grid; a cell above the top row is a lock-out
+    Board::Row* grid = rows(board) + TOP_ROWS;
+    const Orientation& orientation = Tetromino::SHAPES[mType[board]][mRotation[board]];
+    const Board::PieceRows& piece = orientation.rows;
+    bool lockedOut = mY[board] + orientation.min.y < 0; // As in Simulation::lock
+    for (int r = 0; r < 4; ++r) {
+        int gridY = mY[board] + r;
+        if (piece[r] != 0 && gridY >= 0 && gridY < HEIGHT) {
+            grid[gridY] |= static_cast<Board::Row>(piece[r] << (mX[board] + PADDING));
+        }
+    }
+
+    int linesCleared = clearFullLines(board);
+    mLinesCleared[board] += linesCleared;
+    mScore[board] += Simulation::POINTS_PER_LINE * linesCleared;
+
+    spawn(board);
+    if (lockedOut || collides(board, mType[board], 0, mX[board], mY[board])) { // Or the stack reached the spawn point
+        mLives[board]--;
+        if (mLives[board] > 0) {
+            clearBoard(board); // Continue on an empty board
+        } else {
+            mGameOver[board] = 1;
+        }
+    }
+    return linesCleared;
+}
+
+void BoardBatch::spawn(std::size_t board) {
+    Random random(mRandomState[board]);
+    mType[board] = mNextType[board];
+    mNextType[board] = static_cast<std::uint8_t>(random.nextInt(TetrominoTables::TYPE_COUNT));
+    mRandomState[board] = random.getState();
+    mRotation[board] = 0;
+    mX[board] = Simulation::SPAWN_X;
+    mY[board] = 0;
+    mPieceCount[board]++;
+}
+
+Board::Row BoardBatch::getRow(std::size_t board, int y) const {
+    return static_cast<Board::Row>((rows(board)[y + TOP_ROWS] & PLAYFIELD_MASK) >> PADDING);
+}
+
+Tetromino BoardBatch::getCurrentTetromino(std::size_t board) const {
+    Tetromino tetromino(mType[board], mX[board], mY[board]);
+    tetromino.setRotation(mRotation[board]);
+    return tetromino;
+}
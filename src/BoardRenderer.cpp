@@ -0,0 +1,138 @@
+#include "BoardRenderer.h"
+#include "Profiler.h"
+#include <algorithm>
+
+static sf::Color toColor(const Rgb& rgb, std::uint8_t alpha = 255) {
+    return sf::Color(rgb.r, rgb.g, rgb.b, alpha);
+}
+
+BoardRenderer::BoardRenderer(int cellSize, const sf::Vector2i& previewOffset)
+    : mCellSize(cellSize),
+      mPreviewOffset(previewOffset),
+      mVertices(sf::PrimitiveType::Triangles, QUAD_COUNT * VERTICES_PER_QUAD),
+      mDrawnRows(),
+      mValid(false)
+{
+    // Gray backdrop showing through the gaps between empty cells as grid lines
+    setQuad(BACKDROP_QUAD, sf::Vector2f(0, 0),
+            sf::Vector2f(Board::WIDTH * cellSize + 1, Board::HEIGHT * cellSize + 1), sf::Color(128, 128, 128));
+}
+
+void BoardRenderer::invalidate() {
+    mValid = false;
+}
+
+void BoardRenderer::update(const Simulation& simulation, float fallOffset, const Placement* hint) {
+    ProfileScope probe("BoardRenderer::update");
+    const Board& board = simulation.getBoard();
+    for (int y = 0; y < Board::HEIGHT; ++y) {
+        const std::uint8_t* colors = board.getRowColors(y);
+        if (!mValid || !std::equal(colors, colors + Board::WIDTH, mDrawnRows[y].begin())) {
+            updateRow(board, y);
+        }
+    }
+    mValid = true;
+
+    const Tetromino* current = &simulation.getCurrentTetromino();
+    const Tetromino* next = &simulation.getNextTetromino();
+    const Rgb& color = Tetromino::COLORS[current->getType()];
+    if (hint) {
+        Tetromino hinted(current->getType(), hint->x, hint->y);
+        hinted.setRotation(hint->rotation);
+        updateHint(&hinted);
+    } else {
+        updateHint(nullptr);
+    }
+    updatePiece(GHOST_QUADS, current, sf::Vector2f(0, simulation.getDropDistance()), toColor(color, 80));
+    updatePiece(PIECE_QUADS, current, sf::Vector2f(0, fallOffset), toColor(color));
+    updatePiece(PREVIEW_QUADS, next, sf::Vector2f(mPreviewOffset), toColor(Tetromino::COLORS[next->getType()]));
+}
+
+void BoardRenderer::draw(sf::RenderTarget& target) const {
+    ProfileScope probe("BoardRenderer::draw");
+    target.draw(mVertices);
+}
+
+void BoardRenderer::setQuad(int quad, const sf::Vector2f& position, const sf::Vector2f& size, const sf::Color& color) {
+    sf::Vertex* v = &mVertices[quad * VERTICES_PER_QUAD];
+    const sf::Vector2f topRight(position.x + size.x, position.y);
+    const sf::Vector2f bottomLeft(position.x, position.y + size.y);
+    const sf::Vector2f bottomRight(position.x + size.x, position.y + size.y);
+
+    v[0].position = position;
+    v[1].position = topRight;
+    v[2].position = bottomLeft;
+    v[3].position = bottomLeft;
+    v[4].position = topRight;
+    v[5].position = bottomRight;
+    for (int i = 0; i < VERTICES_PER_QUAD; ++i) {
+        v[i].color = color;
+    }
+}
+
+void BoardRenderer::updateRow(const Board& board, int y) {
+    const std::uint8_t* colors = board.getRowColors(y);
+    for (int x = 0; x < Board::WIDTH; ++x) {
+        int quad = CELL_QUADS + y * Board::WIDTH + x;
+        sf::Vector2f position(x * mCellSize, y * mCellSize);
+        if (colors[x] == 0) {
+            // Empty cells are inset by a pixel to leave the grid lines visible
+            setQuad(quad, position + sf::Vector2f(1, 1), sf::Vector2f(mCellSize - 1, mCellSize - 1), sf::Color::Black);
+        } else {
+            // The board stores type + 1, so subtract 1 to get the actual type index
+            setQuad(quad, position, sf::Vector2f(mCellSize, mCellSize), toColor(Tetromino::COLORS[colors[x] - 1]));
+        }
+        mDrawnRows[y][x] = colors[x];
+    }
+}
+
+void BoardRenderer::updatePiece(int firstQuad, const Tetromino* tetromino, const sf::Vector2f& offset, const sf::Color& color) {
+    if (!tetromino) {
+        for (int i = 0; i < 4; ++i) {
+            setQuad(firstQuad + i, sf::Vector2f(0, 0), sf::Vector2f(0, 0), sf::Color::Transparent);
+        }
+        return;
+    }
+
+    const Cell position = tetromino->getPosition();
+    const std::array<Cell, 4>& shape = tetromino->getShape();
+    for (int i = 0; i < 4; ++i) {
+        sf::Vector2f blockPosition((position.x + shape[i].x + offset.x) * mCellSize,
+                                   (position.y + shape[i].y + offset.y) * mCellSize);
+        setQuad(firstQuad + i, blockPosition, sf::Vector2f(mCellSize, mCellSize), color);
+    }
+}
+
+void BoardRenderer::updateHint(const Tetromino* tetromino) {
+    static const sf::Color HINT_COLOR(255, 255, 255, 200);
+    const float thickness = std::max(2, mCellSize / 10);
+    const float size = static_cast<float>(mCellSize);
+
+    // A bar along each side of a cell whose neighbor there is not part of the piece
+    int quad = HINT_QUADS;
+    if (tetromino) {
+        const Cell position = tetromino->getPosition();
+        const Board::PieceRows& rows = tetromino->getOrientation().rows;
+        auto inPiece = [&rows](int x, int y) {
+            return x >= 0 && x < 4 && y >= 0 && y < 4 && ((rows[y] >> x) & 1u);
+        };
+        for (const Cell& cell : tetromino->getShape()) {
+            sf::Vector2f corner((position.x + cell.x) * size, (position.y + cell.y) * size);
+            if (!inPiece(cell.x, cell.y - 1)) {
+                setQuad(quad++, corner, sf::Vector2f(size, thickness), HINT_COLOR);
+            }
+            if (!inPiece(cell.x, cell.y + 1)) {
+                setQuad(quad++, corner + sf::Vector2f(0, size - thickness), sf::Vector2f(size, thickness), HINT_COLOR);
+            }
+            if (!inPiece(cell.x - 1, cell.y)) {
+                setQuad(quad++, corner, sf::Vector2f(thickness, size), HINT_COLOR);
+            }
+            if (!inPiece(cell.x + 1, cell.y)) {
+                setQuad(quad++, corner + sf::Vector2f(size - thickness, 0), sf::Vector2f(thickness, size), HINT_COLOR);
+            }
+        }
+    }
+    for (; quad < HINT_QUADS + HINT_EDGE_COUNT; ++quad) {
+        setQuad(quad, sf::Vector2f(0, 0), sf::Vector2f(0, 0), sf::Color::Transparent);
+    }
+}
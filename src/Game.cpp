@@ -1,9 +1,14 @@
-#include <fstream> 
 #include "Game.h"
+#include "EmbeddedFont.h"
+#include "Profiler.h"
+#include <iomanip>
 #include <iostream>
-#include <random> // For random number generation
 #include <string> // For std::to_string
+#include <sstream>
 #include <algorithm> // For std::max
+#include <ctime>
+#include <filesystem>
+#include <fstream>
 
 // Define a set of colors for level transitions
 const std::vector<sf::Color> LevelColors = {
@@ -20,37 +25,94 @@ const std::vector<sf::Color> LevelColors = {
     // Add more colors if needed for higher levels, they will cycle
 };
 
-sf::Font Game::loadFont(const std::string& fontPath) {
+sf::Font Game::loadFont(sf::Time& loadTime) {
+    ProfileScope probe("loadFont");
+    sf::Clock clock;
     sf::Font font;
-    if (!font.openFromFile(fontPath)) {
-        std::cerr << "Failed to load font from " << fontPath << std::endl;
+    if (!font.openFromMemory(EmbeddedFont::DATA, EmbeddedFont::SIZE)) {
+        std::cerr << "Failed to load the embedded font" << std::endl;
         exit(1); // Or a more graceful exit
     }
+    loadTime = clock.getElapsedTime();
     return font;
 }
 
-Game::Game() 
-    : mWindow(sf::VideoMode({500, 500}), "Tetris"), // New window size (increased width)
+void Game::prewarmGlyphs() {
+    ProfileScope probe("prewarmGlyphs");
+    sf::Clock clock;
+
+    // Every string drawn, at the size it is drawn at. SFML rasterizes a glyph
+    // the first time it is laid out, which would otherwise happen mid-game.
+    const struct {
+        const char* text;
+        unsigned size;
+    } strings[] = {
+        {"0123456789 Score: Level: Lives: Best: NEXT:", 24},
+        {"Game Over!", 40},
+        {"Start Close", 50},
+    };
+    for (const auto& entry : strings) {
+        for (const char* c = entry.text; *c; ++c) {
+            mFont.getGlyph(static_cast<unsigned char>(*c), entry.size, false);
+        }
+    }
+    // The profiler overlay shows probe names, so take all of printable ASCII
+    for (char32_t c = 32; c < 127; ++c) {
+        mFont.getGlyph(c, mProfilerText.getCharacterSize(), false);
+    }
+    mGlyphPrewarmTime = clock.getElapsedTime();
+}
+
+void Game::reportStartup() {
+    std::cout << std::fixed << std::setprecision(1)
+              << "Startup: ready in " << mConstructionTime.asSeconds() * 1000.0f << " ms (font "
+              << mFontLoadTime.asSeconds() * 1000.0f << " ms, glyphs " << mGlyphPrewarmTime.asSeconds() * 1000.0f
+              << " ms), first frame shown at " << mStartupClock.getElapsedTime().asSeconds() * 1000.0f << " ms"
+              << std::defaultfloat << std::endl;
+}
+
+Game::Game(const GameSettings& settings)
+    : mFirstFrameShown(false),
+      mSettings(settings),
+      mWindow(sf::VideoMode({500, 500}), "Tetris"), // New window size (increased width)
       mState(MENU),
-      mFont(loadFont("C:/Windows/Fonts/arial.ttf")),
+      mFont(loadFont(mFontLoadTime)),
       mMenuText_Start(mFont, "Start", 50),
       mMenuText_Close(mFont, "Close", 50),
-      mGrid(GRID_HEIGHT, std::vector<int>(GRID_WIDTH, 0)),
-      mFallTime(sf::seconds(0.5f)), // Initial fall speed
-      mTimeSinceLastFall(sf::Time::Zero),
-      mScore(0),
-      mLevel(1),
+      mBoardRenderer(CELL_SIZE, sf::Vector2i(GRID_WIDTH + 3, 12)), // Preview slightly to the right and down
+      mPacingStats(1.0f / (settings.frameRateLimit > 0 ? settings.frameRateLimit : settings.tickRate)),
+      mInputHandler(settings.inputTiming),
+      mUndisplayedPressTime(-1.0),
+      mProfilerText(mFont, "", 12),
+      mTraceWritten(false),
+      mTickSeconds(0.0f),
+      mGameTick(0),
+      mReplayMode(!settings.replayPath.empty()),
+      mShowHint(settings.hint && settings.replayPath.empty()),
+      mHintValid(false),
+      mHint{0, 0, 0},
+      mHintPieceCount(-1),
+      mPreviousPiecePosition{0, 0},
+      mPreviousPieceRotation(0),
+      mPreviousPieceCount(0),
       mPreviousLevel(1), // Initialize mPreviousLevel to 1
-      mLinesCleared(0),
-      mPointsToNextLevel(100), // Initialize mPointsToNextLevel to 100 for the first level up
-      mLives(3),               // Initialize mLives to 3
       mScoreText(mFont), // Initialize mScoreText
       mLevelText(mFont),  // Initialize mLevelText
-      mBestScore(0), // Initialize mBestScore
+      mScores(settings.scorePath, "best_score.txt"), // Imports the old best score once
       mBestScoreText(mFont), // Initialize mBestScoreText
+      mLivesText(mFont, "", 24),
+      mNextText(mFont, "NEXT:", 24),
+      mGameOverText(mFont, "Game Over!", 40), // Smaller font size
+      mShownScore(-1),
+      mShownLevel(-1),
+      mShownLives(-1),
+      mShownBestScore(-1),
       mCurrentBgColor(sf::Color::Black), // Initial background color
+      mStartBgColor(sf::Color::Black),
       mTargetBgColor(sf::Color::Black),   // Target background color (initially black)
-      mLevelTransitionDuration(sf::seconds(2.0f)) // 2-second transition
+      mLevelTransitionDuration(sf::seconds(2.0f)), // 2-second transition
+      mTransitionActive(false),
+      mDirty(true)
 
 {
     mMenuText_Start.setPosition(sf::Vector2f(200, 200)); // Adjusted position for wider window
@@ -74,343 +136,506 @@ Game::Game()
     mBestScoreText.setFillColor(sf::Color::Yellow); // Differentiate best score color
     mBestScoreText.setPosition(sf::Vector2f(GRID_WIDTH * CELL_SIZE + 50, 200)); // Position below lives
 
-    loadScores(); // Load best score at startup
-
-
-
-}
+    mLivesText.setFillColor(sf::Color::White);
+    mLivesText.setPosition(sf::Vector2f(GRID_WIDTH * CELL_SIZE + 50, 150)); // Adjusted position below level
+
+    // Label for the next tetromino preview
+    mNextText.setFillColor(sf::Color::White);
+    mNextText.setPosition(sf::Vector2f(GRID_WIDTH * CELL_SIZE + 50, 250)); // Adjusted position (moved up)
+
+    mGameOverText.setFillColor(sf::Color::Red);
+    // Manually approximate centering without relying on getLocalBounds() for origin
+    // Assuming text origin is top-left, approximate center by half its calculated width/height
+    // Approx text width: 9 chars * 40px/char = 360px
+    // Approx text height: 40px
+    // Centered X: (window_width / 2) - (text_width / 2) = (400 / 2) - (360 / 2) = 200 - 180 = 20
+    // Centered Y: (window_height / 2) - (text_height / 2) = (500 / 2) - (40 / 2) = 250 - 20 = 230
+    mGameOverText.setPosition(sf::Vector2f(70.0f, 230.0f));
+
+    mProfilerText.setFillColor(sf::Color(200, 255, 200));
+    mProfilerText.setPosition(sf::Vector2f(4, 4));
+    Profiler::instance().setEnabled(mSettings.profile);
+
+    // Let SFML sleep between frames instead of spinning a core
+    mWindow.setVerticalSyncEnabled(mSettings.verticalSync);
+    mWindow.setFramerateLimit(mSettings.frameRateLimit);
+    // Held keys repeat on InputHandler's DAS and ARR timers, not the OS's
+    mWindow.setKeyRepeatEnabled(false);
+
+    if (mSettings.spectatorPort != 0) {
+        mSpectators.listenTcp(static_cast<std::uint16_t>(mSettings.spectatorPort));
+    }
+    if (!mSettings.spectatorSocket.empty()) {
+        mSpectators.listenUnix(mSettings.spectatorSocket);
+    }
 
-void Game::spawnTetromino() {
-    static std::random_device rd;
-    static std::mt19937 gen(rd());
-    static std::uniform_int_distribution<> distrib(0, Tetromino::SHAPES.size() - 1);
-
-    // If mNextTetromino is not yet initialized (first call from constructor/restartGame),
-    // generate both current and next Tetrominoes.
-    if (!mNextTetromino) {
-        int typeCurrent = distrib(gen);
-        mCurrentTetromino = std::make_unique<Tetromino>(typeCurrent, GRID_WIDTH / 2 - 2, 0);
-
-        int typeNext = distrib(gen);
-        mNextTetromino = std::make_unique<Tetromino>(typeNext, 0, 0); 
-    } else { // Subsequent calls, cycle the Tetrominoes
-        mCurrentTetromino = std::move(mNextTetromino); // mCurrentTetromino takes mNextTetromino
-        // Use move to set position, as setPosition was removed.
-        // It moves from (0,0) to (GRID_WIDTH / 2 - 2, 0)
-        mCurrentTetromino->move(GRID_WIDTH / 2 - 2, 0); 
-
-        // Generate new mNextTetromino for preview, position (0,0) for display offset
-        int typeNext = distrib(gen);
-        mNextTetromino = std::make_unique<Tetromino>(typeNext, 0, 0);
+    if (mReplayMode) {
+        if (!mReplayFile.open(mSettings.replayPath) ||
+            !mReplayPlayer.open(mReplayFile.getData(), mReplayFile.getSize())) {
+            std::cerr << "Unable to read replay " << mSettings.replayPath << std::endl;
+            mWindow.close();
+            return;
+        }
+        // Play back at the recorded tick rate, so 1x is real time
+        mSettings.tickRate = mReplayPlayer.getHeader().tickRate;
+        restartGame();
     }
+    mTickSeconds = ReplayFormat::tickSeconds(mSettings.tickRate);
+
+    prewarmGlyphs();
+    mConstructionTime = mStartupClock.getElapsedTime();
 }
 
 void Game::restartGame() {
-    mGrid = std::vector<std::vector<int>>(GRID_HEIGHT, std::vector<int>(GRID_WIDTH, 0)); // Clear grid
-    mScore = 0;
-    mLevel = 1;
+    if (mReplayMode) {
+        mReplayPlayer.start(mSimulation); // Click to watch the replay again
+    } else {
+        mSimulation.reset();
+        if (!mSettings.recordDirectory.empty()) {
+            startRecording();
+        }
+    }
+    mGameTick = 0;
+    mInputHandler.reset();
     mPreviousLevel = 1; // Reset previous level for background transition
-    mLives = 3;         // Reset lives
-    mLinesCleared = 0;
-    mFallTime = sf::seconds(0.5f); // Reset fall speed
-    mTimeSinceLastFall = sf::Time::Zero;
-    spawnTetromino();
     mState = PLAYING;
+    mDirty = true;
 }
 
-void Game::run() {
-    sf::Clock clock;
-    while (mWindow.isOpen()) {
-        sf::Time deltaTime = clock.restart();
-        processEvents();
-        update(deltaTime);
-        render();
+void Game::startRecording() {
+    std::ostringstream path;
+    path << mSettings.recordDirectory << "/replay-" << std::hex << mSimulation.getSeed() << ReplayFormat::EXTENSION;
+    if (!mReplayWriter.open(path.str(), ReplayHeader{mSimulation.getSeed(), mSettings.tickRate})) {
+        std::cerr << "Unable to open " << path.str() << " for writing." << std::endl;
     }
 }
 
-void Game::processEvents() {
-    while (const std::optional<sf::Event> event = mWindow.pollEvent()) {
-        if (event->is<sf::Event::Closed>()) {
-            mWindow.close();
+void Game::saveGame() {
+    std::vector<std::uint8_t> bytes;
+    mSimulation.saveState(bytes);
+
+    // Write a temporary file and rename it over the old save, so a power cut
+    // never leaves a half-written game behind
+    std::string temporaryPath = mSettings.savePath + ".tmp";
+    {
+        std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+        file.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+        if (!file.good()) {
+            std::cerr << "Unable to write " << temporaryPath << std::endl;
+            return;
         }
+    }
+    std::error_code error;
+    std::filesystem::rename(temporaryPath, mSettings.savePath, error);
+    if (error) {
+        std::cerr << "Unable to save the game to " << mSettings.savePath << ": " << error.message() << std::endl;
+        return;
+    }
+    std::cout << "Game saved to " << mSettings.savePath << std::endl;
+}
 
-        if (mState == MENU) {
-            if (event->is<sf::Event::MouseButtonPressed>()) {
-                const auto* mouseButtonPressed = event->getIf<sf::Event::MouseButtonPressed>();
-                if (mouseButtonPressed->button == sf::Mouse::Button::Left) {
-                    sf::Vector2f mousePos(mouseButtonPressed->position.x, mouseButtonPressed->position.y);
-                    if (mMenuText_Start.getGlobalBounds().contains(mousePos)) {
-                        restartGame(); // Call restartGame
-                    }
-                    if (mMenuText_Close.getGlobalBounds().contains(mousePos)) {
-                        mWindow.close();
-                    }
+void Game::resumeGame() {
+    MappedFile file;
+    if (!file.open(mSettings.savePath) || !mSimulation.loadState(file.getData(), file.getSize())) {
+        std::cerr << "No saved game to resume in " << mSettings.savePath << std::endl;
+        return;
+    }
+    // A replay must start from the seed, so the resumed game is not recorded
+    mReplayWriter.finish(mGameTick);
+    mGameTick = 0;
+    mInputHandler.reset();
+
+    const Tetromino& current = mSimulation.getCurrentTetromino();
+    mPreviousPiecePosition = current.getPosition();
+    mPreviousPieceRotation = current.getRotation();
+    mPreviousPieceCount = mSimulation.getPieceCount();
+    mPreviousLevel = mSimulation.getLevel();
+    mCurrentBgColor = LevelColors[(mPreviousLevel - 1) % LevelColors.size()];
+    mTargetBgColor = mCurrentBgColor;
+    mTransitionActive = false;
+
+    mState = mSimulation.isGameOver() ? GAME_OVER : PLAYING;
+    mDirty = true;
+    std::cout << "Resumed the game saved in " << mSettings.savePath << std::endl;
+}
+
+void Game::run() {
+    const sf::Time tickTime = sf::seconds(1.0f / mSettings.tickRate);
+    sf::Clock clock;
+    sf::Time accumulator = sf::Time::Zero;
+
+    while (mWindow.isOpen()) {
+        if (mState != PLAYING) {
+            // Nothing moves on the menu and game over screens, so sleep until
+            // an event arrives and only redraw what changed. Spectator sockets
+            // are the only other work, so only a game over shown to spectators
+            // sets a timeout.
+            bool spectating = mState == GAME_OVER && mSpectators.isListening();
+            bool animating = updateBackground();
+            if (!mDirty && !animating) {
+                std::optional<sf::Event> event = spectating
+                    ? mWindow.waitEvent(sf::seconds(SPECTATOR_WAKE_SECONDS))
+                    : mWindow.waitEvent();
+                if (event) {
+                    handleEvent(*event);
                 }
             }
-        } else if (mState == PLAYING) {
-            if (event->is<sf::Event::KeyPressed>()) {
-                const auto* keyPressed = event->getIf<sf::Event::KeyPressed>();
-                if (mCurrentTetromino) {
-                    if (keyPressed->scancode == sf::Keyboard::Scancode::Left) {
-                        if (!checkCollision(*mCurrentTetromino, -1, 0)) {
-                            mCurrentTetromino->move(-1, 0);
-                        }
-                    } else if (keyPressed->scancode == sf::Keyboard::Scancode::Right) {
-                        if (!checkCollision(*mCurrentTetromino, 1, 0)) {
-                            mCurrentTetromino->move(1, 0);
-                        }
-                    } else if (keyPressed->scancode == sf::Keyboard::Scancode::Down) {
-                        if (!checkCollision(*mCurrentTetromino, 0, 1)) {
-                            mCurrentTetromino->move(0, 1);
-                        }
-                    } else if (keyPressed->scancode == sf::Keyboard::Scancode::Up) {
-                        std::vector<sf::Vector2i> rotatedShape = mCurrentTetromino->getRotatedShape();
-                        if (!checkCollision(*mCurrentTetromino, 0, 0, &rotatedShape)) {
-                            mCurrentTetromino->setShape(rotatedShape);
-                        }
-                    }
-                }
+            processEvents();
+            if (animating || mDirty) {
+                render(0.0f);
             }
-        } else if (mState == GAME_OVER) { // New: allow restarting from game over screen
-            if (event->is<sf::Event::MouseButtonPressed>()) {
-                const auto* mouseButtonPressed = event->getIf<sf::Event::MouseButtonPressed>();
-                if (mouseButtonPressed->button == sf::Mouse::Button::Left) {
-                    restartGame(); // Restart game on click
-                }
+            if (spectating) {
+                // Lets new spectators join and see the final board. Nothing is
+                // published on the menu, since no game has been played from it.
+                publishToSpectators();
             }
+            // Idle time is neither frame time nor simulation time
+            clock.restart();
+            accumulator = sf::Time::Zero;
+            continue;
         }
-    }
-}
 
-void Game::update(sf::Time deltaTime) {
-    if (mState != PLAYING) {
-        return;
-    }
+        ProfileScope frameProbe("frame");
+        sf::Time frameTime = clock.restart();
+        double frameStart = inputTime();
+        accumulator += frameTime;
+        processEvents();
 
-    mTimeSinceLastFall += deltaTime;
+        // Advance the simulation in fixed ticks, so gravity does not depend
+        // on the frame rate. Tick i of this frame covers the real time up to
+        // tickEnd, and inputs due by then are applied before it runs, so a
+        // repeat lands on the tick it fell due in rather than the frame.
+        int ticks = 0;
+        while (accumulator >= tickTime && ticks < MAX_TICKS_PER_FRAME) {
+            double tickEnd = frameStart - accumulator.asSeconds() + tickTime.asSeconds();
+            update(tickEnd);
+            accumulator -= tickTime;
+            ticks++;
+        }
+        // Keys pressed since the last tick take effect now rather than a
+        // tick later; they are recorded against the next tick
+        applyInputs(inputTime());
+        publishToSpectators();
+        updateHint();
+
+        // After a stall (window drag, breakpoint) drop the backlog instead of
+        // fast-forwarding through it
+        int droppedTicks = 0;
+        if (accumulator >= tickTime) {
+            droppedTicks = static_cast<int>(accumulator / tickTime);
+            accumulator = accumulator % tickTime;
+        }
 
-    // Update score/level texts
-    mScoreText.setString("Score: " + std::to_string(mScore));
-    mLevelText.setString("Level: " + std::to_string(mLevel));
+        updateBackground();
+        render(accumulator / tickTime);
 
-    // Adjust fall time based on level
-    mFallTime = sf::seconds(std::max(0.05f, 0.5f - mLevel * 0.05f));
+        if (mPacingStats.recordFrame(frameTime.asSeconds(), ticks, droppedTicks) && mSettings.printPacingStats) {
+            std::cout << "Pacing: " << mPacingStats.getLastWindow() << std::endl;
+        }
+    }
 
-    // Level up logic:
-    if (mScore >= mPointsToNextLevel) {
-        mLevel++;
-        mPointsToNextLevel += 100; // Increase points needed for next level by 100 each time
+    if (mSettings.printPacingStats) {
+        mPacingStats.printSummary(std::cout);
+    }
+    mReplayWriter.finish(mGameTick); // Keep a game quit midway
+    if (Profiler::instance().isEnabled() && !mTraceWritten) {
+        writeTrace();
     }
+}
 
-    // Background color transition logic
-    if (mLevel != mPreviousLevel) {
-        // Level changed, start new transition
-        mLevelTransitionClock.restart();
-        mTargetBgColor = LevelColors[(mLevel - 1) % LevelColors.size()]; // Get target color for new level
-        mPreviousLevel = mLevel; // Update previous level
+void Game::toggleProfiler() {
+    mDirty = true; // Show or hide the overlay
+    Profiler& profiler = Profiler::instance();
+    profiler.setEnabled(!profiler.isEnabled());
+    if (profiler.isEnabled()) {
+        profiler.clear(); // Show only frames since the overlay came up
+        mProfilerText.setString("Profiling...");
+        mProfilerOverlayClock.restart();
     }
+}
 
-    sf::Time elapsed = mLevelTransitionClock.getElapsedTime();
-    if (elapsed < mLevelTransitionDuration) {
-        float progress = elapsed.asSeconds() / mLevelTransitionDuration.asSeconds();
-        
-        // Linear interpolation for each color component
-        mCurrentBgColor.r = static_cast<unsigned char>(mCurrentBgColor.r + (mTargetBgColor.r - mCurrentBgColor.r) * progress);
-        mCurrentBgColor.g = static_cast<unsigned char>(mCurrentBgColor.g + (mTargetBgColor.g - mCurrentBgColor.g) * progress);
-        mCurrentBgColor.b = static_cast<unsigned char>(mCurrentBgColor.b + (mTargetBgColor.b - mCurrentBgColor.b) * progress);
+void Game::writeTrace() {
+    if (Profiler::instance().writeChromeTrace(mSettings.tracePath)) {
+        std::cout << "Trace written to " << mSettings.tracePath << std::endl;
+        mTraceWritten = true;
     } else {
-        mCurrentBgColor = mTargetBgColor; // Ensure final color is set when transition completes
+        std::cerr << "Unable to write trace to " << mSettings.tracePath << std::endl;
+    }
+}
+
+void Game::updateProfilerOverlay() {
+    std::ostringstream text;
+    text << std::fixed << std::setprecision(2) << "probe  p50 / p99 ms\n";
+    for (const Profiler::ProbeStats& stats : Profiler::instance().summarize()) {
+        text << stats.name << "  " << stats.p50Ms << " / " << stats.p99Ms << "\n";
+    }
+    mProfilerText.setString(text.str());
+}
+
+void Game::processEvents() {
+    ProfileScope probe("processEvents");
+    while (const std::optional<sf::Event> event = mWindow.pollEvent()) {
+        handleEvent(*event);
+    }
+}
+
+void Game::handleEvent(const sf::Event& event) {
+    if (event.is<sf::Event::Closed>()) {
+        mWindow.close();
+    }
+    // The window contents may need repainting
+    if (event.is<sf::Event::Resized>() || event.is<sf::Event::FocusGained>()) {
+        mDirty = true;
     }
 
-    if (mTimeSinceLastFall >= mFallTime) {
-        if (mCurrentTetromino && !checkCollision(*mCurrentTetromino, 0, 1)) {
-            mCurrentTetromino->move(0, 1);
-        } else if (mCurrentTetromino) {
-            // Collision detected, lock the tetromino to the grid
-            sf::Vector2i position = mCurrentTetromino->getPosition();
-            const std::vector<sf::Vector2i>& shape = mCurrentTetromino->getShape();
-            int color = mCurrentTetromino->getType() + 1; // Use type + 1 as color ID
+    // Profiler keys work in every state
+    if (const auto* keyPressed = event.getIf<sf::Event::KeyPressed>()) {
+        if (keyPressed->scancode == sf::Keyboard::Scancode::F3) {
+            toggleProfiler();
+        } else if (keyPressed->scancode == sf::Keyboard::Scancode::F4) {
+            writeTrace();
+        } else if (keyPressed->scancode == sf::Keyboard::Scancode::F5 && mState == PLAYING && !mReplayMode) {
+            saveGame();
+        } else if (keyPressed->scancode == sf::Keyboard::Scancode::F9 && !mReplayMode) {
+            resumeGame();
+        }
+    }
 
-            for (const auto& p : shape) {
-                if (position.y + p.y >= 0) { // Only place if block is within grid
-                    mGrid[position.y + p.y][position.x + p.x] = color;
+    if (mState == MENU) {
+        if (event.is<sf::Event::MouseButtonPressed>()) {
+            const auto* mouseButtonPressed = event.getIf<sf::Event::MouseButtonPressed>();
+            if (mouseButtonPressed->button == sf::Mouse::Button::Left) {
+                sf::Vector2f mousePos(mouseButtonPressed->position.x, mouseButtonPressed->position.y);
+                if (mMenuText_Start.getGlobalBounds().contains(mousePos)) {
+                    restartGame(); // Call restartGame
                 }
-            }
-            
-            clearFullLines(); // Call new method here
-
-            spawnTetromino();
-            if (checkCollision(*mCurrentTetromino, 0, 0)) { // Check for game over
-                mLives--; // Decrement a life
-                if (mLives > 0) {
-                    // Reset game state for next life (clear grid, reset score/level if desired, or just continue)
-                    mGrid = std::vector<std::vector<int>>(GRID_HEIGHT, std::vector<int>(GRID_WIDTH, 0)); // Clear grid
-                } else {
-                    if (mScore > mBestScore) {
-                        mBestScore = mScore;
-                        saveScores();
-                    }
-                    mState = GAME_OVER;
-                    std::cout << "Game Over!" << std::endl;
+                if (mMenuText_Close.getGlobalBounds().contains(mousePos)) {
+                    mWindow.close();
                 }
             }
         }
-        mTimeSinceLastFall = sf::Time::Zero;
-    }
-}
-
-void Game::drawGrid() {
-    sf::RectangleShape cell(sf::Vector2f(CELL_SIZE, CELL_SIZE));
-    for (int y = 0; y < GRID_HEIGHT; ++y) {
-        for (int x = 0; x < GRID_WIDTH; ++x) {
-            cell.setPosition(sf::Vector2f(x * CELL_SIZE, y * CELL_SIZE));
-            if (mGrid[y][x] == 0) {
-                cell.setFillColor(sf::Color::Black);
-                cell.setOutlineColor(sf::Color(128, 128, 128)); // Gray
-                cell.setOutlineThickness(1);
-            } else {
-                // Get the color from Tetromino::COLORS based on the grid value
-                // mGrid stores type + 1, so subtract 1 to get the actual type index
-                cell.setFillColor(Tetromino::COLORS[mGrid[y][x] - 1]);
-                cell.setOutlineThickness(0);
+    } else if (mState == PLAYING) {
+        if (const auto* keyPressed = event.getIf<sf::Event::KeyPressed>()) {
+            if (keyPressed->scancode == sf::Keyboard::Scancode::H && !mReplayMode) {
+                mShowHint = !mShowHint;
+                mHintPieceCount = -1; // Search again for the piece in play
+            }
+            handleKey(keyPressed->scancode, true);
+        } else if (const auto* keyReleased = event.getIf<sf::Event::KeyReleased>()) {
+            handleKey(keyReleased->scancode, false);
+        } else if (event.is<sf::Event::FocusLost>()) {
+            mInputHandler.releaseAll(inputTime()); // Key releases go to the other window
+        }
+    } else if (mState == GAME_OVER) { // New: allow restarting from game over screen
+        if (event.is<sf::Event::MouseButtonPressed>()) {
+            const auto* mouseButtonPressed = event.getIf<sf::Event::MouseButtonPressed>();
+            if (mouseButtonPressed->button == sf::Mouse::Button::Left) {
+                restartGame(); // Restart game on click
             }
-            mWindow.draw(cell);
         }
     }
 }
 
-bool Game::checkCollision(const Tetromino& tetromino, int offsetX, int offsetY, const std::vector<sf::Vector2i>* newShape) const {
-    const std::vector<sf::Vector2i>& shape = (newShape) ? *newShape : tetromino.getShape();
-    sf::Vector2i position = tetromino.getPosition();
+void Game::handleKey(sf::Keyboard::Scancode scancode, bool pressed) {
+    InputHandler::Action action;
+    switch (scancode) {
+        case sf::Keyboard::Scancode::Left:  action = InputHandler::Action::Left;     break;
+        case sf::Keyboard::Scancode::Right: action = InputHandler::Action::Right;    break;
+        case sf::Keyboard::Scancode::Down:  action = InputHandler::Action::SoftDrop; break;
+        case sf::Keyboard::Scancode::Space: action = InputHandler::Action::HardDrop; break;
+        case sf::Keyboard::Scancode::Up:    action = InputHandler::Action::Rotate;   break;
+        default: return;
+    }
+    if (mReplayMode) {
+        return;
+    }
+    // SFML events carry no timestamp, so the time they are polled is the
+    // closest there is
+    if (pressed) {
+        mInputHandler.press(action, inputTime());
+    } else {
+        mInputHandler.release(action, inputTime());
+    }
+}
 
-    for (const auto& p : shape) {
-        int x = position.x + p.x + offsetX;
-        int y = position.y + p.y + offsetY;
+double Game::inputTime() const {
+    return mInputClock.getElapsedTime().asMicroseconds() * 1e-6;
+}
 
-        // Check horizontal boundaries
-        if (x < 0 || x >= GRID_WIDTH) {
-            return true;
-        }
-        // Check bottom boundary
-        if (y >= GRID_HEIGHT) {
-            return true;
-        }
-        // Check collision with existing blocks on the grid (if y is within grid bounds)
-        // Only check if y is not above the grid (i.e., y >= 0)
-        if (y >= 0 && mGrid[y][x] != 0) {
-            return true;
+void Game::applyInputs(double before) {
+    if (mState != PLAYING || mReplayMode) {
+        return;
+    }
+    InputHandler::Event event;
+    while (!mSimulation.isGameOver() && mInputHandler.next(before, event)) {
+        mReplayWriter.record(mGameTick, event.input);
+        mSimulation.step(event.input, 0.0f); // Apply the move without advancing time
+        if (!event.repeat && mUndisplayedPressTime < 0.0) {
+            mUndisplayedPressTime = event.time;
         }
     }
-    return false;
 }
 
-void Game::clearFullLines() {
-    int linesClearedThisTurn = 0;
-    for (int y = GRID_HEIGHT - 1; y >= 0; --y) {
-        bool fullLine = true;
-        for (int x = 0; x < GRID_WIDTH; ++x) {
-            if (mGrid[y][x] == 0) {
-                fullLine = false;
-                break;
-            }
+void Game::update(double tickEnd) {
+    applyInputs(tickEnd);
+    if (mState != PLAYING) {
+        return;
+    }
+    ProfileScope probe("update");
+
+    // Remember where the piece was, for render() to interpolate from
+    const Tetromino& current = mSimulation.getCurrentTetromino();
+    mPreviousPiecePosition = current.getPosition();
+    mPreviousPieceRotation = current.getRotation();
+    mPreviousPieceCount = mSimulation.getPieceCount();
+
+    // Gravity, locking, line clears, scoring and levels
+    if (mReplayMode) {
+        for (unsigned i = 0; i < mSettings.replaySpeed && mReplayPlayer.tick(mSimulation); ++i) {
         }
+    } else {
+        mSimulation.step(Simulation::Input::None, mTickSeconds);
+        mGameTick++;
+    }
 
-        if (fullLine) {
-            linesClearedThisTurn++;
-            // Shift all lines above down by one
-            for (int rowToMove = y; rowToMove > 0; --rowToMove) {
-                for (int x = 0; x < GRID_WIDTH; ++x) {
-                    mGrid[rowToMove][x] = mGrid[rowToMove - 1][x];
-                }
-            }
-            // Clear the top line
-            for (int x = 0; x < GRID_WIDTH; ++x) {
-                mGrid[0][x] = 0;
-            }
-            // Re-check the same line, as it's now filled with the line above
-            y++; 
+    if (mSimulation.isGameOver() || (mReplayMode && mReplayPlayer.isFinished())) {
+        if (!mReplayMode) {
+            mReplayWriter.finish(mGameTick);
+            std::int64_t endedAt = static_cast<std::int64_t>(std::time(nullptr));
+            std::uint32_t durationMs = static_cast<std::uint32_t>(mGameTick * 1000ull / mSettings.tickRate);
+            mScores.submit(GameRecord{mSimulation.getScore(), mSimulation.getLevel(), mSimulation.getLinesCleared(),
+                                      durationMs, mSimulation.getSeed(), endedAt});
         }
+        mState = GAME_OVER;
+        mDirty = true;
+        std::cout << "Game Over!" << std::endl;
+        return;
     }
 
-    // Update score and level based on lines cleared
-    if (linesClearedThisTurn > 0) {
-        mScore += 20 * linesClearedThisTurn; // 20 points per line
-        // Level up logic will be handled in update() based on score
+    // Start a background transition when the level changes
+    int level = mSimulation.getLevel();
+    if (level != mPreviousLevel) {
+        mLevelTransitionClock.restart();
+        mStartBgColor = mCurrentBgColor;
+        mTargetBgColor = LevelColors[(level - 1) % LevelColors.size()]; // Get target color for new level
+        mPreviousLevel = level; // Update previous level
+        mTransitionActive = true;
+    }
+}
+
+bool Game::updateBackground() {
+    if (!mTransitionActive) {
+        return false;
+    }
+    sf::Time elapsed = mLevelTransitionClock.getElapsedTime();
+    if (elapsed < mLevelTransitionDuration) {
+        float progress = elapsed.asSeconds() / mLevelTransitionDuration.asSeconds();
+
+        // Linear interpolation for each color component
+        mCurrentBgColor.r = static_cast<unsigned char>(mStartBgColor.r + (mTargetBgColor.r - mStartBgColor.r) * progress);
+        mCurrentBgColor.g = static_cast<unsigned char>(mStartBgColor.g + (mTargetBgColor.g - mStartBgColor.g) * progress);
+        mCurrentBgColor.b = static_cast<unsigned char>(mStartBgColor.b + (mTargetBgColor.b - mStartBgColor.b) * progress);
+    } else {
+        mCurrentBgColor = mTargetBgColor; // Ensure final color is set when transition completes
+        mTransitionActive = false;
     }
+    return true; // Also true for the frame that settles on the target color
 }
 
-void Game::render() {
+void Game::render(float alpha) {
+    ProfileScope probe("render");
     mWindow.clear(mCurrentBgColor); // Use dynamically changing background color
 
     if (mState == MENU) {
         mWindow.draw(mMenuText_Start);
         mWindow.draw(mMenuText_Close);
     } else if (mState == PLAYING) {
-        drawGrid();
-        if (mCurrentTetromino) {
-            mCurrentTetromino->draw(mWindow, CELL_SIZE);
+        // Slide the falling piece between its last two tick positions. Only the
+        // fall is interpolated, so moves and rotations show up immediately.
+        const Tetromino& current = mSimulation.getCurrentTetromino();
+        float fallOffset = 0.0f;
+        if (mSimulation.getPieceCount() == mPreviousPieceCount &&
+            current.getRotation() == mPreviousPieceRotation &&
+            current.getPosition().x == mPreviousPiecePosition.x) {
+            fallOffset = (mPreviousPiecePosition.y - current.getPosition().y) * (1.0f - alpha);
         }
-        mScoreText.setString("Score: " + std::to_string(mScore)); // Update score text
+
+        mBoardRenderer.update(mSimulation, fallOffset, mShowHint && mHintValid ? &mHint : nullptr);
+        mBoardRenderer.draw(mWindow); // Grid, ghost, falling piece and preview
+        updateHud();
         mWindow.draw(mScoreText);
-        mLevelText.setString("Level: " + std::to_string(mLevel)); // Update level text
         mWindow.draw(mLevelText);
-        mBestScoreText.setString("Best: " + std::to_string(mBestScore)); // Update best score text
         mWindow.draw(mBestScoreText);
-
-        sf::Text livesText(mFont, "Lives: " + std::to_string(mLives), 24);
-        livesText.setFillColor(sf::Color::White);
-        livesText.setPosition(sf::Vector2f(GRID_WIDTH * CELL_SIZE + 50, 150)); // Adjusted position below level
-        mWindow.draw(livesText);
-
-        // Draw next tetromino preview
-        if (mNextTetromino) {
-            sf::Text nextText(mFont, "NEXT:", 24);
-            nextText.setFillColor(sf::Color::White);
-            nextText.setPosition(sf::Vector2f(GRID_WIDTH * CELL_SIZE + 50, 250)); // Adjusted position (moved up)
-            mWindow.draw(nextText);
-
-            // Draw the next tetromino slightly to the right and down
-            // Adjust position for a smaller preview and centered appearance
-            mNextTetromino->draw(mWindow, CELL_SIZE, sf::Vector2i(GRID_WIDTH + 3, 12)); // Adjusted offset (moved up)
-        }
+        mWindow.draw(mLivesText);
+        mWindow.draw(mNextText);
     } else if (mState == GAME_OVER) {
-        sf::Text gameOverText(mFont, "Game Over!", 40); // Smaller font size
-        gameOverText.setFillColor(sf::Color::Red);
-        // Manually approximate centering without relying on getLocalBounds() for origin
-        // Assuming text origin is top-left, approximate center by half its calculated width/height
-        // Approx text width: 9 chars * 40px/char = 360px
-        // Approx text height: 40px
-        // Centered X: (window_width / 2) - (text_width / 2) = (400 / 2) - (360 / 2) = 200 - 180 = 20
-        // Centered Y: (window_height / 2) - (text_height / 2) = (500 / 2) - (40 / 2) = 250 - 20 = 230
-        gameOverText.setPosition(sf::Vector2f(70.0f, 230.0f));
-        mWindow.draw(gameOverText);
-        mScoreText.setString("Score: " + std::to_string(mScore)); // Update score text
+        updateHud();
+        mWindow.draw(mGameOverText);
         mWindow.draw(mScoreText); // Display final score
-        mLevelText.setString("Level: " + std::to_string(mLevel)); // Update level text
         mWindow.draw(mLevelText); // Display final level
-        mBestScoreText.setString("Best: " + std::to_string(mBestScore)); // Update best score text
         mWindow.draw(mBestScoreText); // Display best score on game over screen
     }
-    
+
+    if (Profiler::instance().isEnabled()) {
+        if (mProfilerOverlayClock.getElapsedTime() >= sf::seconds(0.5f)) {
+            updateProfilerOverlay();
+            mProfilerOverlayClock.restart();
+        }
+        mWindow.draw(mProfilerText);
+    }
+
     mWindow.display();
+    mDirty = false;
+
+    if (mUndisplayedPressTime >= 0.0) {
+        mPacingStats.recordInputLatency(static_cast<float>(inputTime() - mUndisplayedPressTime));
+        mUndisplayedPressTime = -1.0;
+    }
+
+    if (!mFirstFrameShown) {
+        mFirstFrameShown = true;
+        reportStartup();
+    }
 }
 
-void Game::saveScores() {
-    std::ofstream outFile("best_score.txt");
-    if (outFile.is_open()) {
-        outFile << mBestScore;
-        outFile.close();
-    } else {
-        std::cerr << "Unable to open best_score.txt for writing." << std::endl;
+void Game::updateHint() {
+    // The piece only changes when one locks, so one search per piece is
+    // enough; its time budget keeps the frame on schedule
+    if (!mShowHint || mState != PLAYING || mSimulation.getPieceCount() == mHintPieceCount) {
+        return;
     }
+    if (!mHintSearch) {
+        mHintSearch = std::make_unique<LookaheadSearch>();
+    }
+    mHintPieceCount = mSimulation.getPieceCount();
+    mHintValid = mHintSearch->findBest(mSimulation, mHint, mSettings.hintBudget);
 }
 
-void Game::loadScores() {
-    std::ifstream inFile("best_score.txt");
-    if (inFile.is_open()) {
-        inFile >> mBestScore;
-        inFile.close();
-    } else {
-        mBestScore = 0; // If file doesn't exist, best score is 0
+void Game::publishToSpectators() {
+    if (!mSpectators.isListening()) {
+        return;
+    }
+    std::uint32_t tick = mReplayMode ? mReplayPlayer.getTick() : mGameTick;
+    mSpectators.publish(SpectatorSnapshot::capture(mSimulation, tick));
+}
+
+void Game::updateHud() {
+    // Setting a string re-lays out the text and allocates, so only do it when
+    // a value changed
+    if (mSimulation.getScore() != mShownScore) {
+        mShownScore = mSimulation.getScore();
+        mScoreText.setString("Score: " + std::to_string(mShownScore));
     }
-}
\ No newline at end of file
+    if (mSimulation.getLevel() != mShownLevel) {
+        mShownLevel = mSimulation.getLevel();
+        mLevelText.setString("Level: " + std::to_string(mShownLevel));
+    }
+    if (mSimulation.getLives() != mShownLives) {
+        mShownLives = mSimulation.getLives();
+        mLivesText.setString("Lives: " + std::to_string(mShownLives));
+    }
+    if (mScores.getBestScore() != mShownBestScore) {
+        mShownBestScore = mScores.getBestScore();
+        mBestScoreText.setString("Best: " + std::to_string(mShownBestScore));
+    }
+}
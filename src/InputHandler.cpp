@@ -0,0 +1,128 @@
+#include "InputHandler.h"
+#include <algorithm>
+
+namespace {
+
+// A zero repeat rate means "as fast as possible"; 1 ms still crosses the board
+// within a frame without flooding the caller
+constexpr double MIN_INTERVAL = 0.001;
+
+SimulationBase::Input toInput(InputHandler::Action action) {
+    switch (action) {
+        case InputHandler::Action::Left:     return SimulationBase::Input::Left;
+        case InputHandler::Action::Right:    return SimulationBase::Input::Right;
+        case InputHandler::Action::SoftDrop: return SimulationBase::Input::Down;
+        case InputHandler::Action::HardDrop: return SimulationBase::Input::HardDrop;
+        case InputHandler::Action::Rotate:   return SimulationBase::Input::Rotate;
+        case InputHandler::Action::COUNT:    break;
+    }
+    return SimulationBase::Input::None;
+}
+
+bool isHorizontal(InputHandler::Action action) {
+    return action == InputHandler::Action::Left || action == InputHandler::Action::Right;
+}
+
+} // namespace
+
+InputHandler::InputHandler(const InputTiming& timing)
+    : mTiming(timing),
+      mHorizontal(Action::Left)
+{
+}
+
+void InputHandler::press(Action action, double time) {
+    Key& pressed = key(action);
+    if (pressed.held) {
+        return;
+    }
+    pressed.held = true;
+    pressed.pressPending = true;
+    pressed.pressTime = time;
+    if (isHorizontal(action)) {
+        pressed.nextRepeat = time + std::max(static_cast<double>(mTiming.das), 0.0);
+        mHorizontal = action;
+    } else {
+        pressed.nextRepeat = time + repeatInterval(action);
+    }
+}
+
+void InputHandler::release(Action action, double time) {
+    Key& released = key(action);
+    if (!released.held) {
+        return;
+    }
+    released.held = false;
+
+    // Hand the repeat back to the other direction if it is still held
+    if (isHorizontal(action) && action == mHorizontal) {
+        Action other = (action == Action::Left) ? Action::Right : Action::Left;
+        if (key(other).held) {
+            key(other).nextRepeat = time + std::max(static_cast<double>(mTiming.das), 0.0);
+            mHorizontal = other;
+        }
+    }
+}
+
+void InputHandler::releaseAll(double time) {
+    for (int i = 0; i < static_cast<int>(Action::COUNT); ++i) {
+        release(static_cast<Action>(i), time);
+    }
+}
+
+void InputHandler::reset() {
+    mKeys.fill(Key());
+    mHorizontal = Action::Left;
+}
+
+bool InputHandler::next(double before, Event& event) {
+    // Find the earliest due press or repeat; ties go to the lower action
+    int earliest = -1;
+    double earliestTime = before;
+    bool earliestIsRepeat = false;
+    for (int i = 0; i < static_cast<int>(Action::COUNT); ++i) {
+        const Key& candidate = mKeys[i];
+        if (candidate.pressPending) {
+            if (candidate.pressTime < earliestTime) {
+                earliest = i;
+                earliestTime = candidate.pressTime;
+                earliestIsRepeat = false;
+            }
+        } else if (repeats(static_cast<Action>(i)) && candidate.nextRepeat < earliestTime) {
+            earliest = i;
+            earliestTime = candidate.nextRepeat;
+            earliestIsRepeat = true;
+        }
+    }
+    if (earliest < 0) {
+        return false;
+    }
+
+    Action action = static_cast<Action>(earliest);
+    Key& due = mKeys[earliest];
+    if (earliestIsRepeat) {
+        due.nextRepeat += repeatInterval(action);
+    } else {
+        due.pressPending = false;
+    }
+    event.time = earliestTime;
+    event.input = toInput(action);
+    event.repeat = earliestIsRepeat;
+    return true;
+}
+
+bool InputHandler::repeats(Action action) const {
+    const Key& held = mKeys[static_cast<int>(action)];
+    if (!held.held) {
+        return false;
+    }
+    if (isHorizontal(action)) {
+        return action == mHorizontal;
+    }
+    return action == Action::SoftDrop;
+}
+
+double InputHandler::repeatInterval(Action action) const {
+    float interval = (action == Action::SoftDrop) ? mTiming.softDrop : mTiming.arr;
+    return std::max(static_cast<double>(interval), MIN_INTERVAL);
+}
@@ -0,0 +1,270 @@
+#include "LookaheadSearch.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <array>
+#include <cstring>
+
+namespace {
+
+// SplitMix64, as in Random, usable at compile time for the key tables
+constexpr std::uint64_t mixKey(std::uint64_t index) {
+    std::uint64_t z = 0x5EED5EEDull + (index + 1) * 0x9E3779B97F4A7C15ull;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+template <std::size_t Count, std::uint64_t First>
+constexpr std::array<std::uint64_t, Count> makeKeys() {
+    std::array<std::uint64_t, Count> keys = {};
+    for (std::size_t i = 0; i < Count; ++i) {
+        keys[i] = mixKey(First + i);
+    }
+    return keys;
+}
+
+constexpr int CELL_COUNT = Board::WIDTH * Board::HEIGHT;
+constexpr std::array<std::uint64_t, CELL_COUNT> CELL_KEYS = makeKeys<CELL_COUNT, 0>();
+// Told apart from the board by the plies left below the node
+constexpr std::array<std::uint64_t, LookaheadSearch::MAX_DEPTH + 1> DEPTH_KEYS =
+    makeKeys<LookaheadSearch::MAX_DEPTH + 1, CELL_COUNT>();
+
+constexpr std::uint64_t VALID_BIT = 1ull << 32;
+
+std::uint64_t packValue(float value) {
+    std::uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return VALID_BIT | bits;
+}
+
+float unpackValue(std::uint64_t data) {
+    std::uint32_t bits = static_cast<std::uint32_t>(data);
+    float value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+} // namespace
+
+TranspositionTable::TranspositionTable(int sizeBits)
+    : mEntries(new Entry[std::size_t(1) << sizeBits]),
+      mMask((std::uint64_t(1) << sizeBits) - 1)
+{
+    for (std::uint64_t i = 0; i <= mMask; ++i) {
+        mEntries[i].check.store(0, std::memory_order_relaxed);
+        mEntries[i].data.store(0, std::memory_order_relaxed);
+    }
+}
+
+bool TranspositionTable::probe(std::uint64_t key, float& value) const {
+    const Entry& entry = mEntries[key & mMask];
+    std::uint64_t data = entry.data.load(std::memory_order_relaxed);
+    std::uint64_t check = entry.check.load(std::memory_order_relaxed);
+    if (!(data & VALID_BIT) || (check ^ data) != key) {
+        return false;
+    }
+    value = unpackValue(data);
+    return true;
+}
+
+void TranspositionTable::store(std::uint64_t key, float value) {
+    Entry& entry = mEntries[key & mMask];
+    std::uint64_t data = packValue(value);
+    entry.check.store(key ^ data, std::memory_order_relaxed);
+    entry.data.store(data, std::memory_order_relaxed);
+}
+
+LookaheadSearch::LookaheadSearch(unsigned threadCount, int tableBits, const HeuristicWeights& weights)
+    : mPool(threadCount > 0 ? std::make_unique<WorkStealingPool>(threadCount) : nullptr),
+      mTable(tableBits),
+      mWeights(weights),
+      mCurrentType(0),
+      mNextType(0),
+      mHasDeadline(false),
+      mAborted(false),
+      mChanceNodes(0),
+      mTableHits(0),
+      mCompletedDepth(0)
+{
+}
+
+std::uint64_t LookaheadSearch::hashBoard(const Board& board) {
+    std::uint64_t hash = 0;
+    for (int y = 0; y < Board::HEIGHT; ++y) {
+        Board::Row row = board.getRow(y);
+        for (int x = 0; x < Board::WIDTH; ++x) {
+            // Branch-free: XOR the key in when the cell is occupied
+            hash ^= CELL_KEYS[y * Board::WIDTH + x] & (0 - static_cast<std::uint64_t>((row >> x) & 1u));
+        }
+    }
+    return hash;
+}
+
+bool LookaheadSearch::findBest(const Simulation& simulation, Placement& best, double budgetSeconds, int maxDepth) {
+    ProfileScope probe("lookahead");
+    mHasDeadline = budgetSeconds > 0.0;
+    mDeadline = Clock::now() + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(budgetSeconds));
+    mAborted = false;
+    mChanceNodes = 0;
+    mTableHits = 0;
+    mCompletedDepth = 0;
+
+    mBoard = simulation.getBoard();
+    mNextType = simulation.getNextTetromino().getType();
+    mCurrentType = simulation.getCurrentTetromino().getType();
+    const Tetromino& current = simulation.getCurrentTetromino();
+    int count = mRootSearch.search(mBoard, current);
+    if (count == 0) {
+        return false;
+    }
+    mRootValues.resize(count);
+    while (static_cast<int>(mChildSearches.size()) < count) {
+        mChildSearches.push_back(std::make_unique<PlacementSearch>());
+    }
+
+    maxDepth = std::max(1, std::min(maxDepth, MAX_DEPTH));
+    for (int depth = 1; depth <= maxDepth; ++depth) {
+        if (depth == 1 || !mPool) {
+            for (int i = 0; i < count && !mAborted; ++i) {
+                mRootValues[i] = rootChildValue(i, depth);
+            }
+        } else {
+            for (int i = 0; i < count; ++i) {
+                mPool->submit([this, i, depth] { mRootValues[i] = rootChildValue(i, depth); });
+            }
+            mPool->wait();
+        }
+        if (mAborted) {
+            break; // Keep the answer of the last complete ply
+        }
+
+        int bestIndex = 0;
+        for (int i = 1; i < count; ++i) {
+            if (mRootValues[i] > mRootValues[bestIndex]) {
+                bestIndex = i;
+            }
+        }
+        best = mRootSearch.getPlacement(bestIndex);
+        mCompletedDepth = depth;
+        if (outOfTime()) {
+            break;
+        }
+    }
+    return true;
+}
+
+bool LookaheadSearch::outOfTime() {
+    if (mAborted.load(std::memory_order_relaxed)) {
+        return true;
+    }
+    if (mHasDeadline && Clock::now() >= mDeadline) {
+        mAborted = true;
+        return true;
+    }
+    return false;
+}
+
+float LookaheadSearch::rootChildValue(int index, int depth) {
+    const Placement& placement = mRootSearch.getPlacement(index);
+    Board board = mBoard;
+    board.place(Tetromino::SHAPES[mCurrentType][placement.rotation].rows, placement.x, placement.y, mCurrentType + 1);
+    int lines = board.clearFullLines();
+
+    float rest;
+    if (depth == 1) {
+        // The next piece must still fit at the spawn point
+        bool toppedOut = board.collides(Tetromino::SHAPES[mNextType][0].rows, Simulation::SPAWN_X, 0);
+        rest = toppedOut ? LOSS_SCORE : PlacementSearch::evaluate(board, 0, mWeights);
+    } else {
+        rest = knownPieceValue(board, mNextType, depth - 1, *mChildSearches[index]);
+    }
+    return rest <= LOSS_SCORE ? LOSS_SCORE : mWeights.linesCleared * lines + rest;
+}
+
+float LookaheadSearch::knownPieceValue(const Board& board, int type, int depth, PlacementSearch& search) {
+    if (depth > 1 && outOfTime()) {
+        return 0.0f;
+    }
+    int count = search.search(board, Tetromino(type, Simulation::SPAWN_X, 0));
+    if (count == 0) {
+        return LOSS_SCORE; // Blocked at the spawn point
+    }
+
+    float best = LOSS_SCORE;
+    for (int i = 0; i < count; ++i) {
+        const Placement& placement = search.getPlacement(i);
+        float value;
+        if (depth == 1) {
+            value = PlacementSearch::scorePlacement(board, type, placement, mWeights);
+        } else {
+            if (outOfTime()) {
+                return 0.0f; // Discarded by findBest
+            }
+            Board next = board;
+            next.place(Tetromino::SHAPES[type][placement.rotation].rows, placement.x, placement.y, type + 1);
+            int lines = next.clearFullLines();
+            value = mWeights.linesCleared * lines + chanceValue(next, depth - 1);
+        }
+        best = std::max(best, value);
+    }
+    return best;
+}
+
+float LookaheadSearch::chanceValue(const Board& board, int depth) {
+    if (outOfTime()) {
+        return 0.0f;
+    }
+    std::uint64_t key = hashBoard(board) ^ DEPTH_KEYS[depth];
+    float value;
+    if (mTable.probe(key, value)) {
+        mTableHits.fetch_add(1, std::memory_order_relaxed);
+        return value;
+    }
+    mChanceNodes.fetch_add(1, std::memory_order_relaxed);
+
+    // Every piece type is equally likely
+    float sum = 0.0f;
+    for (int type = 0; type < TetrominoTables::TYPE_COUNT; ++type) {
+        sum += dropValue(board, type, depth);
+    }
+    value = sum / TetrominoTables::TYPE_COUNT;
+    if (!mAborted.load(std::memory_order_relaxed)) { // A value cut short is wrong
+        mTable.store(key, value);
+    }
+    return value;
+}
+
+float LookaheadSearch::dropValue(const Board& board, int type, int depth) {
+    const auto& orientations = Tetromino::SHAPES[type];
+    if (board.collides(orientations[0].rows, Simulation::SPAWN_X, 0)) {
+        return LOSS_SCORE;
+    }
+
+    // Speculative pieces are only dropped straight down from the top, which
+    // is a few lookups per column instead of a full reachability search
+    float best = LOSS_SCORE;
+    for (int rotation = 0; rotation < Tetromino::ROTATION_COUNT; ++rotation) {
+        if (PlacementSearch::canonicalRotation(type, rotation) != rotation) {
+            continue;
+        }
+        const Orientation& orientation = orientations[rotation];
+        for (int x = -orientation.min.x; x < Board::WIDTH - orientation.max.x; ++x) {
+            if (board.collides(orientation.rows, x, 0)) {
+                continue;
+            }
+            int y = board.dropDistance(orientation.rows, orientation.bottoms, x, 0);
+            Placement placement{x, y, rotation};
+            float value;
+            if (depth == 1) {
+                value = PlacementSearch::scorePlacement(board, type, placement, mWeights);
+            } else {
+                Board next = board;
+                next.place(orientation.rows, x, y, type + 1);
+                int lines = next.clearFullLines();
+                value = mWeights.linesCleared * lines + chanceValue(next, depth - 1);
+            }
+            best = std::max(best, value);
+        }
+    }
+    return best;
+}
@@ -0,0 +1,64 @@
+#include "MappedFile.h"
+#include <fstream>
+#include <iterator>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define TETRIS_HAS_MMAP 1
+#endif
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+bool MappedFile::open(const std::string& path) {
+    close();
+
+#ifdef TETRIS_HAS_MMAP
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0) {
+        ::close(fd);
+        return false;
+    }
+    mSize = static_cast<std::size_t>(info.st_size);
+    if (mSize > 0) {
+        void* address = mmap(nullptr, mSize, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (address != MAP_FAILED) {
+            mData = static_cast<const std::uint8_t*>(address);
+            mMapped = true;
+        }
+    }
+    ::close(fd);
+    if (mMapped || mSize == 0) {
+        return true;
+    }
+#endif
+
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        return false;
+    }
+    mBuffer.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    mData = mBuffer.data();
+    mSize = mBuffer.size();
+    return true;
+}
+
+void MappedFile::close() {
+#ifdef TETRIS_HAS_MMAP
+    if (mMapped) {
+        munmap(const_cast<std::uint8_t*>(mData), mSize);
+    }
+#endif
+    mData = nullptr;
+    mSize = 0;
+    mMapped = false;
+    mBuffer.clear();
+}
@@ -0,0 +1,103 @@
+#include "PacingStats.h"
+#include <algorithm>
+
+PacingStats::PacingStats(float frameBudget)
+    : mFrameBudget(frameBudget),
+      mWindowTime(0.0f),
+      mMaxFrameTime(0.0f),
+      mFrames(0),
+      mTicks(0),
+      mMissedDeadlines(0),
+      mDroppedTicks(0),
+      mInputs(0),
+      mInputLatencySum(0.0f),
+      mMaxInputLatency(0.0f),
+      mTotalTime(0.0f),
+      mTotalFrames(0),
+      mTotalTicks(0),
+      mTotalMissedDeadlines(0),
+      mTotalDroppedTicks(0),
+      mTotalInputs(0),
+      mTotalInputLatency(0.0),
+      mTotalMaxInputLatency(0.0f)
+{
+}
+
+void PacingStats::recordInputLatency(float latency) {
+    mInputs++;
+    mInputLatencySum += latency;
+    mMaxInputLatency = std::max(mMaxInputLatency, latency);
+}
+
+bool PacingStats::recordFrame(float frameTime, int ticks, int droppedTicks) {
+    mWindowTime += frameTime;
+    mMaxFrameTime = std::max(mMaxFrameTime, frameTime);
+    mFrames++;
+    mTicks += ticks;
+    mDroppedTicks += droppedTicks;
+    if (frameTime > mFrameBudget * 1.5f) {
+        mMissedDeadlines++;
+    }
+
+    if (mWindowTime < 1.0f) {
+        return false;
+    }
+
+    mLastWindow.ticksPerSecond = mTicks / mWindowTime;
+    mLastWindow.framesPerSecond = mFrames / mWindowTime;
+    mLastWindow.averageFrameMs = mWindowTime * 1000.0f / mFrames;
+    mLastWindow.maxFrameMs = mMaxFrameTime * 1000.0f;
+    mLastWindow.missedDeadlines = mMissedDeadlines;
+    mLastWindow.droppedTicks = mDroppedTicks;
+    mLastWindow.inputs = mInputs;
+    mLastWindow.averageInputLatencyMs = mInputs > 0 ? mInputLatencySum * 1000.0f / mInputs : 0.0f;
+    mLastWindow.maxInputLatencyMs = mMaxInputLatency * 1000.0f;
+
+    mTotalTime += mWindowTime;
+    mTotalFrames += mFrames;
+    mTotalTicks += mTicks;
+    mTotalMissedDeadlines += mMissedDeadlines;
+    mTotalDroppedTicks += mDroppedTicks;
+    mTotalInputs += mInputs;
+    mTotalInputLatency += mInputLatencySum;
+    mTotalMaxInputLatency = std::max(mTotalMaxInputLatency, mMaxInputLatency);
+
+    mWindowTime = 0.0f;
+    mMaxFrameTime = 0.0f;
+    mFrames = 0;
+    mTicks = 0;
+    mMissedDeadlines = 0;
+    mDroppedTicks = 0;
+    mInputs = 0;
+    mInputLatencySum = 0.0f;
+    mMaxInputLatency = 0.0f;
+    return true;
+}
+
+void PacingStats::printSummary(std::ostream& out) const {
+    if (mTotalTime <= 0.0f) {
+        return;
+    }
+    out << "Pacing over " << mTotalTime << "s: "
+        << mTotalTicks / mTotalTime << " ticks/s, "
+        << mTotalFrames / mTotalTime << " frames/s, "
+        << mTotalMissedDeadlines << " missed deadlines, "
+        << mTotalDroppedTicks << " dropped ticks" << std::endl;
+    if (mTotalInputs > 0) {
+        out << "Input to display over " << mTotalInputs << " key presses: avg "
+            << mTotalInputLatency * 1000.0 / mTotalInputs << " ms, max "
+            << mTotalMaxInputLatency * 1000.0f << " ms" << std::endl;
+    }
+}
+
+std::ostream& operator<<(std::ostream& out, const PacingStats::Window& window) {
+    return out << window.ticksPerSecond << " ticks/s, "
+               << window.framesPerSecond << " fps, frame avg "
+               << window.averageFrameMs << " ms, max "
+               << window.maxFrameMs << " ms, "
+               << window.missedDeadlines << " missed, "
+               << window.droppedTicks << " dropped ticks, input latency avg "
+               << window.averageInputLatencyMs << " ms, max "
+               << window.maxInputLatencyMs << " ms over "
+               << window.inputs << " presses";
+}
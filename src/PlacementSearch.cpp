@@ -0,0 +1,201 @@
+#include "PlacementSearch.h"
+#include <bitset>
+#include <cstdlib>
+
+namespace {
+
+using CanonicalTable = std::array<std::array<int, Tetromino::ROTATION_COUNT>, TetrominoTables::TYPE_COUNT>;
+
+// Lowest rotation of the same piece that covers the same cells once both are
+// moved to the origin, so symmetric orientations share one placement
+constexpr CanonicalTable makeCanonicalRotations() {
+    CanonicalTable table = {};
+    for (int type = 0; type < TetrominoTables::TYPE_COUNT; ++type) {
+        for (int rotation = 0; rotation < Tetromino::ROTATION_COUNT; ++rotation) {
+            table[type][rotation] = rotation;
+            const Orientation& a = Tetromino::SHAPES[type][rotation];
+            for (int other = 0; other < rotation; ++other) {
+                const Orientation& b = Tetromino::SHAPES[type][other];
+                bool same = (a.max.x - a.min.x == b.max.x - b.min.x) && (a.max.y - a.min.y == b.max.y - b.min.y);
+                for (int row = 0; same && row <= a.max.y - a.min.y; ++row) {
+                    same = (a.rows[a.min.y + row] >> a.min.x) == (b.rows[b.min.y + row] >> b.min.x);
+                }
+                if (same) {
+                    table[type][rotation] = other;
+                    break;
+                }
+            }
+        }
+    }
+    return table;
+}
+
+constexpr CanonicalTable CANONICAL_ROTATIONS = makeCanonicalRotations();
+
+constexpr Board::Row FULL_ROW = (1u << Board::WIDTH) - 1;
+
+} // namespace
+
+int PlacementSearch::search(const Board& board, const Tetromino& piece) {
+    const int type = piece.getType();
+    const auto& orientations = Tetromino::SHAPES[type];
+    const auto& kicks = Tetromino::KICKS[type];
+
+    mVisited.reset();
+    mFinalSeen.reset();
+    mPlacementCount = 0;
+
+    const Cell start = piece.getPosition();
+    if (board.collides(orientations[piece.getRotation()].rows, start.x, start.y)) {
+        return 0;
+    }
+
+    int head = 0;
+    int tail = 0;
+    auto enqueue = [&](int x, int y, int rotation) {
+        if (y < MIN_Y) {
+            return; // Kicked above the tracked area
+        }
+        int index = stateIndex(x, y, rotation);
+        if (!mVisited[index]) {
+            mVisited[index] = true;
+            mQueue[tail++] = static_cast<std::uint16_t>(index);
+        }
+    };
+    enqueue(start.x, start.y, piece.getRotation());
+
+    while (head < tail) {
+        const int index = mQueue[head++];
+        const int x = index % X_RANGE + MIN_X;
+        const int y = (index / X_RANGE) % Y_RANGE + MIN_Y;
+        const int rotation = index / (X_RANGE * Y_RANGE);
+        const Board::PieceRows& rows = orientations[rotation].rows;
+
+        if (!board.collides(rows, x - 1, y)) {
+            enqueue(x - 1, y, rotation);
+        }
+        if (!board.collides(rows, x + 1, y)) {
+            enqueue(x + 1, y, rotation);
+        }
+        if (!board.collides(rows, x, y + 1)) {
+            enqueue(x, y + 1, rotation);
+        } else if (y + orientations[rotation].min.y >= 0) {
+            // Resting on something: a final placement, unless a cell is above
+            // the top row, which is a lock-out. Report it under its canonical
+            // rotation so equal footprints are kept once.
+            const int canonical = CANONICAL_ROTATIONS[type][rotation];
+            const Orientation& from = orientations[rotation];
+            const Orientation& to = orientations[canonical];
+            const int cx = x + from.min.x - to.min.x;
+            const int cy = y + from.min.y - to.min.y;
+            const int finalIndex = stateIndex(cx, cy, canonical);
+            if (!mFinalSeen[finalIndex]) {
+                mFinalSeen[finalIndex] = true;
+                mPlacements[mPlacementCount++] = Placement{cx, cy, canonical};
+            }
+        }
+
+        // Clockwise rotation: the first kick that fits wins, as in Simulation::rotate
+        const int next = Tetromino::nextRotation(rotation);
+        for (const Cell& kick : kicks[rotation]) {
+            if (!board.collides(orientations[next].rows, x + kick.x, y + kick.y)) {
+                enqueue(x + kick.x, y + kick.y, next);
+                break;
+            }
+        }
+    }
+
+    mNodesVisited += tail;
+    return mPlacementCount;
+}
+
+int PlacementSearch::canonicalRotation(int type, int rotation) {
+    return CANONICAL_ROTATIONS[type][rotation];
+}
+
+bool PlacementSearch::findBest(const Board& board, const Tetromino& piece, Placement& best,
+                               const HeuristicWeights& weights) {
+    if (search(board, piece) == 0) {
+        return false;
+    }
+
+    float bestScore = 0.0f;
+    for (int i = 0; i < mPlacementCount; ++i) {
+        float score = scorePlacement(board, piece.getType(), mPlacements[i], weights);
+        if (i == 0 || score > bestScore) {
+            bestScore = score;
+            best = mPlacements[i];
+        }
+    }
+    return true;
+}
+
+float PlacementSearch::scorePlacement(const Board& board, int type, const Placement& placement,
+                                      const HeuristicWeights& weights) {
+    const Board::PieceRows& piece = Tetromino::SHAPES[type][placement.rotation].rows;
+
+    // Lock the piece into a copy of the row masks
+    Rows rows;
+    for (int y = 0; y < Board::HEIGHT; ++y) {
+        rows[y] = board.getRow(y);
+    }
+    for (int r = 0; r < 4; ++r) {
+        int y = placement.y + r;
+        if (piece[r] != 0 && y >= 0 && y < Board::HEIGHT) {
+            rows[y] |= static_cast<Board::Row>(placement.x >= 0 ? piece[r] << placement.x : piece[r] >> -placement.x);
+        }
+    }
+
+    // Clear full rows, compacting towards the bottom
+    int linesCleared = 0;
+    int writeY = Board::HEIGHT - 1;
+    for (int readY = Board::HEIGHT - 1; readY >= 0; --readY) {
+        if (rows[readY] == FULL_ROW) {
+            linesCleared++;
+        } else {
+            rows[writeY--] = rows[readY];
+        }
+    }
+    for (; writeY >= 0; --writeY) {
+        rows[writeY] = 0;
+    }
+
+    return evaluateRows(rows, linesCleared, weights);
+}
+
+float PlacementSearch::evaluate(const Board& board, int linesCleared, const HeuristicWeights& weights) {
+    Rows rows;
+    for (int y = 0; y < Board::HEIGHT; ++y) {
+        rows[y] = board.getRow(y);
+    }
+    return evaluateRows(rows, linesCleared, weights);
+}
+
+float PlacementSearch::evaluateRows(const Rows& rows, int linesCleared, const HeuristicWeights& weights) {
+    // Walk down from the top keeping the union of the rows seen so far. A
+    // column's height is the number of rows at or below its first block, and
+    // every empty cell under that union is a hole. Both loops are branch-free
+    // over fixed-size arrays, so the compiler can vectorize them.
+    int heights[Board::WIDTH] = {};
+    int holes = 0;
+    unsigned covered = 0;
+    for (int y = 0; y < Board::HEIGHT; ++y) {
+        covered |= rows[y];
+        holes += static_cast<int>(std::bitset<Board::WIDTH>(covered & ~rows[y]).count());
+        for (int x = 0; x < Board::WIDTH; ++x) {
+            heights[x] += (covered >> x) & 1u;
+        }
+    }
+
+    int aggregateHeight = 0;
+    int bumpiness = 0;
+    for (int x = 0; x < Board::WIDTH; ++x) {
+        aggregateHeight += heights[x];
+    }
+    for (int x = 0; x + 1 < Board::WIDTH; ++x) {
+        bumpiness += std::abs(heights[x] - heights[x + 1]);
+    }
+
+    return weights.aggregateHeight * aggregateHeight + weights.linesCleared * linesCleared +
+           weights.holes * holes + weights.bumpiness * bumpiness;
+}
@@ -0,0 +1,60 @@
+#include "Policy.h"
+
+// Landing row of a piece dropped straight down from the top of the board, or
+// -1 if it does not fit there at all
+static int dropRow(const Board& board, const Orientation& orientation, int x) {
+    if (board.collides(orientation.rows, x, 0)) {
+        return -1;
+    }
+    return board.dropDistance(orientation.rows, orientation.bottoms, x, 0);
+}
+
+RandomPolicy::RandomPolicy(std::uint64_t seed)
+    : mRandom(seed)
+{
+}
+
+bool RandomPolicy::choose(const Simulation& simulation, Placement& placement) {
+    const Tetromino& piece = simulation.getCurrentTetromino();
+    int rotation = mRandom.nextInt(Tetromino::ROTATION_COUNT);
+    const Orientation& orientation = Tetromino::SHAPES[piece.getType()][rotation];
+
+    // Any column that keeps the piece's bounding box inside the board
+    int minX = -orientation.min.x;
+    int maxX = Board::WIDTH - 1 - orientation.max.x;
+    int x = minX + mRandom.nextInt(maxX - minX + 1);
+
+    int y = dropRow(simulation.getBoard(), orientation, x);
+    if (y < 0) {
+        return false;
+    }
+    placement = Placement{x, y, rotation};
+    return true;
+}
+
+bool GreedyPolicy::choose(const Simulation& simulation, Placement& placement) {
+    return mSearch.findBest(simulation.getBoard(), simulation.getCurrentTetromino(), placement);
+}
+
+LookaheadPolicy::LookaheadPolicy(int depth)
+    : mSearch(0, 16),
+      mDepth(depth)
+{
+}
+
+bool LookaheadPolicy::choose(const Simulation& simulation, Placement& placement) {
+    return mSearch.findBest(simulation, placement, 0.0, mDepth);
+}
+
+std::unique_ptr<PlacementPolicy> makePolicy(const std::string& name, std::uint64_t seed) {
+    if (name == "random") {
+        return std::make_unique<RandomPolicy>(seed);
+    }
+    if (name == "greedy") {
+        return std::make_unique<GreedyPolicy>();
+    }
+    if (name == "lookahead") {
+        return std::make_unique<LookaheadPolicy>(2);
+    }
+    return nullptr;
+}
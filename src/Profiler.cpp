@@ -0,0 +1,157 @@
+#include "Profiler.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+
+namespace {
+
+std::uint32_t currentThreadId() {
+    static std::atomic<std::uint32_t> nextId(0);
+    thread_local std::uint32_t id = nextId.fetch_add(1, std::memory_order_relaxed);
+    return id;
+}
+
+std::int64_t steadyTicks() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+double percentileMs(const std::vector<std::uint64_t>& sorted, double p) {
+    std::size_t index = static_cast<std::size_t>(p * (sorted.size() - 1) + 0.5);
+    return sorted[index] / 1e6;
+}
+
+} // namespace
+
+Profiler::Profiler(std::size_t capacity)
+    : mCapacity(1),
+      mNextIndex(0),
+      mClearedIndex(0),
+      mEnabled(false),
+      mEpoch(steadyTicks())
+{
+    while (mCapacity < capacity) {
+        mCapacity <<= 1;
+    }
+}
+
+Profiler& Profiler::instance() {
+    static Profiler profiler;
+    return profiler;
+}
+
+void Profiler::setEnabled(bool enabled) {
+    if (enabled && !mSlots) {
+        mSlots.reset(new Slot[mCapacity]);
+        for (std::size_t i = 0; i < mCapacity; ++i) {
+            mSlots[i].sequence.store(0, std::memory_order_relaxed);
+        }
+    }
+    mEnabled.store(enabled, std::memory_order_release); // Publishes the buffer
+}
+
+std::uint64_t Profiler::now() const {
+    return static_cast<std::uint64_t>(steadyTicks() - mEpoch);
+}
+
+void Profiler::record(const char* name, std::uint64_t startNs, std::uint64_t durationNs) {
+    std::uint64_t index = mNextIndex.fetch_add(1, std::memory_order_relaxed);
+    Slot& slot = mSlots[index & (mCapacity - 1)];
+
+    slot.sequence.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.name.store(name, std::memory_order_relaxed);
+    slot.startNs.store(startNs, std::memory_order_relaxed);
+    slot.durationNs.store(durationNs, std::memory_order_relaxed);
+    slot.thread.store(currentThreadId(), std::memory_order_relaxed);
+    slot.sequence.store(index + 1, std::memory_order_release);
+}
+
+void Profiler::clear() {
+    // Writers on other threads keep going, so the buffer is left alone and
+    // readers skip every event numbered before this point instead
+    mClearedIndex.store(mNextIndex.load(std::memory_order_relaxed), std::memory_order_release);
+}
+
+std::vector<Profiler::Event> Profiler::snapshot() const {
+    std::vector<Event> events;
+    if (!mSlots) {
+        return events;
+    }
+    std::uint64_t end = mNextIndex.load(std::memory_order_acquire);
+    // A clear() on another thread after end was read can move the start past it
+    std::uint64_t begin = std::min(std::max(end > mCapacity ? end - mCapacity : 0,
+                                            mClearedIndex.load(std::memory_order_acquire)), end);
+
+    events.reserve(static_cast<std::size_t>(end - begin));
+    for (std::uint64_t index = begin; index < end; ++index) {
+        const Slot& slot = mSlots[index & (mCapacity - 1)];
+        std::uint64_t sequence = slot.sequence.load(std::memory_order_acquire);
+        Event event{slot.name.load(std::memory_order_relaxed),
+                    slot.startNs.load(std::memory_order_relaxed),
+                    slot.durationNs.load(std::memory_order_relaxed),
+                    slot.thread.load(std::memory_order_relaxed)};
+        std::atomic_thread_fence(std::memory_order_acquire);
+        // Skip slots still being written or already reused by a newer event
+        if (sequence == index + 1 && slot.sequence.load(std::memory_order_relaxed) == sequence) {
+            events.push_back(event);
+        }
+    }
+    std::sort(events.begin(), events.end(), [](const Event& a, const Event& b) {
+        return a.startNs < b.startNs;
+    });
+    return events;
+}
+
+std::vector<Profiler::ProbeStats> Profiler::summarize() const {
+    std::vector<Event> events = snapshot();
+
+    // Probe names are compared by content, since the same literal can have
+    // different addresses in different translation units
+    std::vector<const char*> names;
+    std::vector<std::vector<std::uint64_t>> durations;
+    for (const Event& event : events) {
+        std::size_t i = 0;
+        while (i < names.size() && std::strcmp(names[i], event.name) != 0) {
+            ++i;
+        }
+        if (i == names.size()) {
+            names.push_back(event.name);
+            durations.emplace_back();
+        }
+        durations[i].push_back(event.durationNs);
+    }
+
+    std::vector<ProbeStats> stats;
+    for (std::size_t i = 0; i < names.size(); ++i) {
+        std::vector<std::uint64_t>& sorted = durations[i];
+        std::sort(sorted.begin(), sorted.end());
+        stats.push_back(ProbeStats{names[i], sorted.size(), percentileMs(sorted, 0.50),
+                                   percentileMs(sorted, 0.99), sorted.back() / 1e6});
+    }
+    return stats;
+}
+
+void Profiler::writeChromeTrace(std::ostream& out) const {
+    std::vector<Event> events = snapshot();
+    out << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n";
+    for (std::size_t i = 0; i < events.size(); ++i) {
+        const Event& event = events[i];
+        // Complete ("X") events with microsecond timestamps
+        out << "{\"name\": \"" << event.name << "\", \"cat\": \"tetris\", \"ph\": \"X\", \"pid\": 1, \"tid\": "
+            << event.thread << ", \"ts\": " << event.startNs / 1000 << '.' << event.startNs % 1000 / 100
+            << ", \"dur\": " << event.durationNs / 1000 << '.' << event.durationNs % 1000 / 100 << '}'
+            << (i + 1 < events.size() ? ",\n" : "\n");
+    }
+    out << "]}" << std::endl;
+}
+
+bool Profiler::writeChromeTrace(const std::string& path) const {
+    std::ofstream out(path);
+    if (!out.is_open()) {
+        return false;
+    }
+    writeChromeTrace(out);
+    return static_cast<bool>(out);
+}
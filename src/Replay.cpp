@@ -0,0 +1,136 @@
+#include "Replay.h"
+#include "ByteOrder.h"
+#include <cstring>
+
+bool ReplayWriter::open(const std::string& path, const ReplayHeader& header) {
+    mFile.open(path, std::ios::binary | std::ios::trunc);
+    if (!mFile.is_open()) {
+        return false;
+    }
+
+    std::uint8_t bytes[ReplayFormat::HEADER_SIZE] = {};
+    std::memcpy(bytes, ReplayFormat::MAGIC, 4);
+    putLittleEndian(bytes + 4, ReplayFormat::VERSION, 2);
+    putLittleEndian(bytes + 8, header.tickRate, 4);
+    putLittleEndian(bytes + 16, header.seed, 8);
+    mFile.write(reinterpret_cast<const char*>(bytes), sizeof(bytes));
+    mLastTick = 0;
+    return mFile.good();
+}
+
+void ReplayWriter::record(std::uint32_t tick, Simulation::Input input) {
+    if (mFile.is_open()) {
+        writeRecord(tick, static_cast<std::uint8_t>(input));
+    }
+}
+
+void ReplayWriter::finish(std::uint32_t tick) {
+    if (mFile.is_open()) {
+        writeRecord(tick, ReplayFormat::END_OF_GAME);
+        mFile.close();
+    }
+}
+
+void ReplayWriter::writeRecord(std::uint32_t tick, std::uint8_t input) {
+    std::uint8_t bytes[6];
+    int length = 0;
+    std::uint32_t delta = tick - mLastTick;
+    do {
+        std::uint8_t byte = delta & 0x7F;
+        delta >>= 7;
+        bytes[length++] = static_cast<std::uint8_t>(delta ? byte | 0x80 : byte);
+    } while (delta);
+    bytes[length++] = input;
+
+    mFile.write(reinterpret_cast<const char*>(bytes), length);
+    mLastTick = tick;
+}
+
+bool ReplayReader::open(const std::uint8_t* data, std::size_t size) {
+    if (size < ReplayFormat::HEADER_SIZE || std::memcmp(data, ReplayFormat::MAGIC, 4) != 0 ||
+        getLittleEndian(data + 4, 2) != ReplayFormat::VERSION) {
+        return false;
+    }
+
+    mHeader.tickRate = static_cast<std::uint32_t>(getLittleEndian(data + 8, 4));
+    mHeader.seed = getLittleEndian(data + 16, 8);
+    if (mHeader.tickRate == 0) {
+        return false;
+    }
+    mData = data;
+    mSize = size;
+    mOffset = ReplayFormat::HEADER_SIZE;
+    mTick = 0;
+    return true;
+}
+
+bool ReplayReader::next(ReplayEvent& event) {
+    std::uint32_t delta = 0;
+    for (int shift = 0; ; shift += 7) {
+        if (mOffset >= mSize || shift > 28) {
+            return false;
+        }
+        std::uint8_t byte = mData[mOffset++];
+        delta |= static_cast<std::uint32_t>(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) {
+            break;
+        }
+    }
+    if (mOffset >= mSize) {
+        return false;
+    }
+
+    std::uint8_t input = mData[mOffset++];
+    mTick += delta;
+    event.tick = mTick;
+    event.endOfGame = (input == ReplayFormat::END_OF_GAME);
+    event.input = event.endOfGame ? Simulation::Input::None : static_cast<Simulation::Input>(input);
+    return true;
+}
+
+bool ReplayPlayer::open(const std::uint8_t* data, std::size_t size) {
+    mData = data;
+    mSize = size;
+    mFinished = true;
+    return mReader.open(data, size);
+}
+
+void ReplayPlayer::start(Simulation& simulation) {
+    mReader.open(mData, mSize); // Rewind
+    simulation.reset(mReader.getHeader().seed);
+    mHasPending = mReader.next(mPending);
+    mFinished = false;
+    mTick = 0;
+}
+
+bool ReplayPlayer::tick(Simulation& simulation, const std::function<void()>& afterStep) {
+    if (mFinished) {
+        return false;
+    }
+
+    while (mHasPending && mPending.tick == mTick) {
+        if (mPending.endOfGame) {
+            mFinished = true;
+            return false;
+        }
+        simulation.step(mPending.input, 0.0f);
+        if (afterStep) {
+            afterStep();
+        }
+        mHasPending = mReader.next(mPending);
+    }
+    if (!mHasPending) {
+        mFinished = true; // Cut short: stop at the last complete record
+        return false;
+    }
+
+    simulation.step(Simulation::Input::None, ReplayFormat::tickSeconds(mReader.getHeader().tickRate));
+    if (afterStep) {
+        afterStep();
+    }
+    mTick++;
+    if (simulation.isGameOver()) {
+        mFinished = true;
+    }
+    return true;
+}
@@ -0,0 +1,412 @@
+#include "ScoreStore.h"
+#include "ByteOrder.h"
+#include "Profiler.h"
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <unistd.h>
+#define TETRIS_HAS_FSYNC 1
+#elif defined(_WIN32)
+#include <io.h>
+#endif
+
+namespace {
+
+constexpr std::size_t SUMMARY_FIXED_SIZE = 40; // Before the leaderboard entries
+constexpr std::size_t MAX_SUMMARY_SIZE = SUMMARY_FIXED_SIZE + ScoreStore::LEADERBOARD_SIZE * ScoreFormat::GAME_SIZE;
+
+// CRC-32 (IEEE), as used by zip and PNG
+struct CrcTable {
+    std::uint32_t entries[256];
+
+    constexpr CrcTable() : entries() {
+        for (std::uint32_t i = 0; i < 256; ++i) {
+            std::uint32_t crc = i;
+            for (int bit = 0; bit < 8; ++bit) {
+                crc = (crc >> 1) ^ (crc & 1 ? 0xEDB88320u : 0u);
+            }
+            entries[i] = crc;
+        }
+    }
+};
+
+constexpr CrcTable CRC_TABLE;
+
+// Pass the CRC of the preceding bytes as previous to continue a checksum
+std::uint32_t crc32(const std::uint8_t* data, std::size_t size, std::uint32_t previous = 0) {
+    std::uint32_t crc = ~previous;
+    for (std::size_t i = 0; i < size; ++i) {
+        crc = (crc >> 8) ^ CRC_TABLE.entries[(crc ^ data[i]) & 0xFF];
+    }
+    return ~crc;
+}
+
+void encodeGame(std::uint8_t* out, const GameRecord& record) {
+    putLittleEndian(out, static_cast<std::uint32_t>(record.score), 4);
+    putLittleEndian(out + 4, static_cast<std::uint32_t>(record.level), 4);
+    putLittleEndian(out + 8, static_cast<std::uint32_t>(record.lines), 4);
+    putLittleEndian(out + 12, record.durationMs, 4);
+    putLittleEndian(out + 16, record.seed, 8);
+    putLittleEndian(out + 24, static_cast<std::uint64_t>(record.endedAt), 8);
+}
+
+GameRecord decodeGame(const std::uint8_t* in) {
+    GameRecord record;
+    record.score = static_cast<std::int32_t>(getLittleEndian(in, 4));
+    record.level = static_cast<std::int32_t>(getLittleEndian(in + 4, 4));
+    record.lines = static_cast<std::int32_t>(getLittleEndian(in + 8, 4));
+    record.durationMs = static_cast<std::uint32_t>(getLittleEndian(in + 12, 4));
+    record.seed = getLittleEndian(in + 16, 8);
+    record.endedAt = static_cast<std::int64_t>(getLittleEndian(in + 24, 8));
+    return record;
+}
+
+// Frames the payload held at out + 5 in place: length and type before it, CRC
+// after it. Returns the frame size.
+std::size_t finishFrame(std::uint8_t* out, std::uint8_t type, std::size_t payloadSize) {
+    putLittleEndian(out, payloadSize, 4);
+    out[4] = type;
+    putLittleEndian(out + 5 + payloadSize, crc32(out + 4, payloadSize + 1), 4);
+    return payloadSize + ScoreFormat::FRAME_OVERHEAD;
+}
+
+// Reads one frame of the given type. Returns the payload size, or -1 if the
+// frame is missing, truncated, too long or fails its CRC.
+long readFrame(std::FILE* file, std::uint8_t type, std::uint8_t* payload, std::size_t maxSize) {
+    std::uint8_t head[5];
+    if (std::fread(head, 1, sizeof(head), file) != sizeof(head) || head[4] != type) {
+        return -1;
+    }
+    std::size_t size = static_cast<std::size_t>(getLittleEndian(head, 4));
+    std::uint8_t crc[4];
+    if (size > maxSize || std::fread(payload, 1, size, file) != size ||
+        std::fread(crc, 1, sizeof(crc), file) != sizeof(crc)) {
+        return -1;
+    }
+    std::uint32_t expected = crc32(payload, size, crc32(&type, 1));
+    return expected == getLittleEndian(crc, 4) ? static_cast<long>(size) : -1;
+}
+
+// Flushes the stdio buffer and waits until the data reaches the disk
+bool syncFile(std::FILE* file) {
+    if (std::fflush(file) != 0) {
+        return false;
+    }
+#if defined(TETRIS_HAS_FSYNC)
+    return fsync(fileno(file)) == 0;
+#elif defined(_WIN32)
+    return _commit(_fileno(file)) == 0;
+#else
+    return true;
+#endif
+}
+
+// Makes a rename in the directory durable
+void syncDirectory(const std::string& path) {
+#ifdef TETRIS_HAS_FSYNC
+    std::string directory = std::filesystem::path(path).parent_path().string();
+    int fd = ::open(directory.empty() ? "." : directory.c_str(), O_RDONLY);
+    if (fd >= 0) {
+        fsync(fd);
+        ::close(fd);
+    }
+#else
+    (void)path;
+#endif
+}
+
+} // namespace
+
+void ScoreStore::Summary::add(const GameRecord& record) {
+    totalGames++;
+    totalLines += static_cast<std::uint64_t>(record.lines);
+    totalDurationMs += record.durationMs;
+
+    // Ties keep the older game first
+    int position = leaderboardCount;
+    while (position > 0 && leaderboard[position - 1].score < record.score) {
+        position--;
+    }
+    if (position >= LEADERBOARD_SIZE) {
+        return;
+    }
+    int last = leaderboardCount < LEADERBOARD_SIZE ? leaderboardCount : LEADERBOARD_SIZE - 1;
+    for (int i = last; i > position; --i) {
+        leaderboard[i] = leaderboard[i - 1];
+    }
+    leaderboard[position] = record;
+    if (leaderboardCount < LEADERBOARD_SIZE) {
+        leaderboardCount++;
+    }
+}
+
+ScoreStore::ScoreStore(const std::string& path, const std::string& legacyPath)
+    : mPath(path),
+      mRecordsStart(0),
+      mValidEnd(0),
+      mAppendedGames(0),
+      mNeedsCompaction(false),
+      mBusy(false),
+      mStopping(false),
+      mFailing(false)
+{
+    mQueue.reserve(16);
+    load(legacyPath);
+    mWorker = std::thread(&ScoreStore::workerLoop, this);
+}
+
+ScoreStore::~ScoreStore() {
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mStopping = true;
+    }
+    mWorkAvailable.notify_one();
+    mWorker.join();
+}
+
+void ScoreStore::submit(const GameRecord& record) {
+    ProfileScope probe("ScoreStore::submit");
+    mSummary.add(record);
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mQueue.push_back(record);
+    }
+    mWorkAvailable.notify_one();
+}
+
+void ScoreStore::flush() {
+    std::unique_lock<std::mutex> lock(mMutex);
+    mIdle.wait(lock, [this] { return (mQueue.empty() && !mBusy) || mFailing; });
+}
+
+void ScoreStore::load(const std::string& legacyPath) {
+    ProfileScope probe("ScoreStore::load");
+    std::FILE* file = std::fopen(mPath.c_str(), "rb");
+    if (file) {
+        std::uint8_t header[ScoreFormat::HEADER_SIZE];
+        std::uint8_t payload[MAX_SUMMARY_SIZE];
+        bool valid = std::fread(header, 1, sizeof(header), file) == sizeof(header) &&
+                     std::memcmp(header, ScoreFormat::MAGIC, 4) == 0 &&
+                     getLittleEndian(header + 4, 2) == ScoreFormat::VERSION;
+        long summarySize = valid ? readFrame(file, ScoreFormat::SUMMARY_FRAME, payload, sizeof(payload)) : -1;
+        int leaderboardCount = summarySize >= static_cast<long>(SUMMARY_FIXED_SIZE)
+                             ? static_cast<int>(getLittleEndian(payload + 32, 4)) : -1;
+        valid = leaderboardCount >= 0 && leaderboardCount <= LEADERBOARD_SIZE &&
+                summarySize == static_cast<long>(SUMMARY_FIXED_SIZE + leaderboardCount * ScoreFormat::GAME_SIZE);
+
+        std::uint64_t compactedGames = 0;
+        if (valid) {
+            compactedGames = getLittleEndian(payload, 8);
+            mSummary.totalGames = getLittleEndian(payload + 8, 8);
+            mSummary.totalLines = getLittleEndian(payload + 16, 8);
+            mSummary.totalDurationMs = getLittleEndian(payload + 24, 8);
+            mSummary.leaderboardCount = leaderboardCount;
+            for (int i = 0; i < leaderboardCount; ++i) {
+                mSummary.leaderboard[i] = decodeGame(payload + SUMMARY_FIXED_SIZE + i * ScoreFormat::GAME_SIZE);
+            }
+            mRecordsStart = ScoreFormat::HEADER_SIZE + ScoreFormat::FRAME_OVERHEAD + summarySize;
+            mValidEnd = mRecordsStart + compactedGames * ScoreFormat::GAME_FRAME_SIZE;
+        }
+
+        // The compacted games must all be there, or the summary is stale
+        std::uint64_t fileSize = 0;
+        if (valid && std::fseek(file, 0, SEEK_END) == 0) {
+            fileSize = static_cast<std::uint64_t>(std::ftell(file));
+        }
+        valid = valid && fileSize >= mValidEnd && std::fseek(file, static_cast<long>(mValidEnd), SEEK_SET) == 0;
+
+        if (valid) {
+            // Games appended since the last compaction. Stop at the first
+            // frame that is torn or corrupt; compaction drops it from the file.
+            std::uint8_t game[ScoreFormat::GAME_SIZE];
+            while (readFrame(file, ScoreFormat::GAME_FRAME, game, sizeof(game)) == ScoreFormat::GAME_SIZE) {
+                mSummary.add(decodeGame(game));
+                mAppendedGames++;
+                mValidEnd += ScoreFormat::GAME_FRAME_SIZE;
+            }
+            if (fileSize != mValidEnd) {
+                std::cerr << "Dropping a damaged record at the end of " << mPath << std::endl;
+                mNeedsCompaction = true;
+            }
+        }
+        std::fclose(file);
+
+        if (valid) {
+            mDiskSummary = mSummary;
+            mNeedsCompaction = mNeedsCompaction || mAppendedGames >= COMPACT_AFTER;
+            return;
+        }
+
+        // Keep the damaged file for inspection and start a new one
+        std::cerr << "Score file " << mPath << " is damaged; moving it to " << mPath << ".damaged" << std::endl;
+        std::error_code error;
+        std::filesystem::rename(mPath, mPath + ".damaged", error);
+        mSummary = Summary();
+        mAppendedGames = 0;
+    }
+
+    // No score file yet: create one, seeded with the old best score if any
+    mRecordsStart = 0;
+    mValidEnd = 0;
+    mNeedsCompaction = true;
+    std::ifstream legacy(legacyPath);
+    int bestScore = 0;
+    if (!legacyPath.empty() && legacy >> bestScore && bestScore > 0 && (legacy >> std::ws).eof()) {
+        GameRecord record = {bestScore, 0, 0, 0, 0, static_cast<std::int64_t>(std::time(nullptr))};
+        mSummary.add(record);
+        mQueue.push_back(record);
+    }
+}
+
+void ScoreStore::workerLoop() {
+    std::vector<GameRecord> batch;
+    batch.reserve(16);
+
+    std::unique_lock<std::mutex> lock(mMutex);
+    while (true) {
+        mWorkAvailable.wait(lock, [this] { return mStopping || !mQueue.empty() || mNeedsCompaction; });
+        if (mStopping && mQueue.empty() && !mNeedsCompaction) {
+            break;
+        }
+        batch.swap(mQueue); // Both keep their capacity, so this does not allocate
+        mBusy = true;
+        lock.unlock();
+
+        bool written = !mNeedsCompaction || compact();
+        if (written && !batch.empty()) {
+            written = append(batch);
+            mNeedsCompaction = !written; // Rewrite the file without a torn append
+        }
+        if (written) {
+            batch.clear();
+            if (mAppendedGames >= COMPACT_AFTER) {
+                compact(); // Retried after the next game if it fails
+            }
+        }
+
+        lock.lock();
+        mBusy = false;
+        if (written) {
+            mFailing = false;
+        } else {
+            mQueue.insert(mQueue.begin(), batch.begin(), batch.end());
+            batch.clear();
+            if (!mFailing) {
+                std::cerr << "Unable to save scores to " << mPath << "; retrying" << std::endl;
+            }
+            mFailing = true;
+            if (mStopping) {
+                std::cerr << "Giving up on " << mQueue.size() << " unsaved games" << std::endl;
+                mQueue.clear();
+                mNeedsCompaction = false;
+            } else {
+                mIdle.notify_all();
+                mWorkAvailable.wait_for(lock, std::chrono::seconds(1));
+                continue;
+            }
+        }
+        mIdle.notify_all();
+    }
+    mIdle.notify_all();
+}
+
+bool ScoreStore::append(const std::vector<GameRecord>& records) {
+    ProfileScope probe("ScoreStore::append");
+    std::FILE* file = std::fopen(mPath.c_str(), "ab");
+    if (!file) {
+        return false;
+    }
+    bool written = true;
+    for (const GameRecord& record : records) {
+        std::uint8_t frame[ScoreFormat::GAME_FRAME_SIZE];
+        encodeGame(frame + 5, record);
+        std::size_t size = finishFrame(frame, ScoreFormat::GAME_FRAME, ScoreFormat::GAME_SIZE);
+        written = written && std::fwrite(frame, 1, size, file) == size;
+    }
+    written = syncFile(file) && written;
+    written = std::fclose(file) == 0 && written;
+    if (!written) {
+        return false;
+    }
+
+    for (const GameRecord& record : records) {
+        mDiskSummary.add(record);
+    }
+    mValidEnd += records.size() * ScoreFormat::GAME_FRAME_SIZE;
+    mAppendedGames += static_cast<int>(records.size());
+    return true;
+}
+
+bool ScoreStore::compact() {
+    ProfileScope probe("ScoreStore::compact");
+    std::uint64_t gameCount = mValidEnd > mRecordsStart
+                            ? (mValidEnd - mRecordsStart) / ScoreFormat::GAME_FRAME_SIZE : 0;
+
+    // Write the new file next to the old one, then swap it in atomically
+    std::string temporaryPath = mPath + ".tmp";
+    std::FILE* out = std::fopen(temporaryPath.c_str(), "wb");
+    if (!out) {
+        return false;
+    }
+
+    std::uint8_t header[ScoreFormat::HEADER_SIZE] = {};
+    std::memcpy(header, ScoreFormat::MAGIC, 4);
+    putLittleEndian(header + 4, ScoreFormat::VERSION, 2);
+
+    std::uint8_t summary[MAX_SUMMARY_SIZE + ScoreFormat::FRAME_OVERHEAD] = {};
+    std::uint8_t* payload = summary + 5;
+    putLittleEndian(payload, gameCount, 8);
+    putLittleEndian(payload + 8, mDiskSummary.totalGames, 8);
+    putLittleEndian(payload + 16, mDiskSummary.totalLines, 8);
+    putLittleEndian(payload + 24, mDiskSummary.totalDurationMs, 8);
+    putLittleEndian(payload + 32, static_cast<std::uint32_t>(mDiskSummary.leaderboardCount), 4);
+    for (int i = 0; i < mDiskSummary.leaderboardCount; ++i) {
+        encodeGame(payload + SUMMARY_FIXED_SIZE + i * ScoreFormat::GAME_SIZE, mDiskSummary.leaderboard[i]);
+    }
+    std::size_t summarySize = finishFrame(summary, ScoreFormat::SUMMARY_FRAME,
+                                          SUMMARY_FIXED_SIZE + mDiskSummary.leaderboardCount * ScoreFormat::GAME_SIZE);
+
+    bool written = std::fwrite(header, 1, sizeof(header), out) == sizeof(header) &&
+                   std::fwrite(summary, 1, summarySize, out) == summarySize;
+
+    // Keep the per-game history: copy every complete game frame across
+    if (written && gameCount > 0) {
+        std::FILE* in = std::fopen(mPath.c_str(), "rb");
+        written = in && std::fseek(in, static_cast<long>(mRecordsStart), SEEK_SET) == 0;
+        std::uint64_t remaining = gameCount * ScoreFormat::GAME_FRAME_SIZE;
+        char buffer[1 << 14];
+        while (written && remaining > 0) {
+            std::size_t chunk = remaining < sizeof(buffer) ? static_cast<std::size_t>(remaining) : sizeof(buffer);
+            written = std::fread(buffer, 1, chunk, in) == chunk && std::fwrite(buffer, 1, chunk, out) == chunk;
+            remaining -= chunk;
+        }
+        if (in) {
+            std::fclose(in);
+        }
+    }
+    written = written && syncFile(out);
+    written = std::fclose(out) == 0 && written;
+
+    std::error_code error;
+    if (written) {
+        std::filesystem::rename(temporaryPath, mPath, error);
+    }
+    if (!written || error) {
+        std::filesystem::remove(temporaryPath, error);
+        return false;
+    }
+    syncDirectory(mPath);
+
+    mRecordsStart = ScoreFormat::HEADER_SIZE + summarySize;
+    mValidEnd = mRecordsStart + gameCount * ScoreFormat::GAME_FRAME_SIZE;
+    mAppendedGames = 0;
+    mNeedsCompaction = false;
+    return true;
+}
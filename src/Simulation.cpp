@@ -0,0 +1,318 @@
+#include "Simulation.h"
+#include "ByteOrder.h"
+#include "Profiler.h"
+#include "SavedGame.h"
+#include <algorithm> // For std::max
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <random>    // For std::random_device
+
+namespace {
+
+std::uint32_t floatBits(float value) {
+    std::uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+float bitsToFloat(std::uint32_t bits) {
+    float value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+std::int32_t getInt32(const std::uint8_t* in) {
+    return static_cast<std::int32_t>(static_cast<std::uint32_t>(getLittleEndian(in, 4)));
+}
+
+} // namespace
+
+template <int Width, int Height>
+BasicSimulation<Width, Height>::BasicSimulation() {
+    reset();
+}
+
+template <int Width, int Height>
+BasicSimulation<Width, Height>::BasicSimulation(std::uint64_t seed) {
+    reset(seed);
+}
+
+std::uint64_t SimulationBase::makeSeed() {
+    std::random_device device;
+    return (static_cast<std::uint64_t>(device()) << 32) ^ device();
+}
+
+template <int Width, int Height>
+void BasicSimulation<Width, Height>::reset() {
+    reset(makeSeed());
+}
+
+template <int Width, int Height>
+void BasicSimulation<Width, Height>::reset(std::uint64_t seed) {
+    mSeed = seed;
+    mRandom = Random(seed);
+    mBoard.clear();
+    mFallTime = 0.5f;
+    mTimeSinceLastFall = 0.0f;
+    mScore = 0;
+    mLevel = 1;
+    mLinesCleared = 0;
+    mPointsToNextLevel = POINTS_PER_LEVEL;
+    mLives = START_LIVES;
+    mGameOver = false;
+    mLastLock = LockResult{0, 0, Placement{0, 0, 0}, 0, 0, false};
+
+    // Draw both pieces from the new seed
+    mCurrentTetromino = Tetromino(mRandom.nextInt(TetrominoTables::TYPE_COUNT), SPAWN_X, 0);
+    mNextTetromino = Tetromino(mRandom.nextInt(TetrominoTables::TYPE_COUNT), 0, 0);
+    mPieceCount = 1;
+}
+
+template <int Width, int Height>
+void BasicSimulation<Width, Height>::spawnTetromino() {
+    mCurrentTetromino = mNextTetromino;
+    mCurrentTetromino.move(SPAWN_X, 0);
+    mNextTetromino = Tetromino(mRandom.nextInt(TetrominoTables::TYPE_COUNT), 0, 0);
+    mPieceCount++;
+}
+
+template <int Width, int Height>
+void BasicSimulation<Width, Height>::step(Input input, float dt) {
+    if (mGameOver) {
+        return;
+    }
+
+    switch (input) {
+        case Input::Left:   move(-1, 0); break;
+        case Input::Right:  move(1, 0);  break;
+        case Input::Down:   move(0, 1);  break;
+        case Input::Rotate: rotate();    break;
+        case Input::HardDrop: hardDrop(); break;
+        case Input::None:   break;
+    }
+    if (mGameOver) { // A hard drop can end the game
+        return;
+    }
+
+    mTimeSinceLastFall += dt;
+    updateLevel();
+
+    if (mTimeSinceLastFall >= mFallTime) {
+        if (!move(0, 1)) {
+            lock();
+        }
+        mTimeSinceLastFall = 0.0f;
+    }
+}
+
+template <int Width, int Height>
+void BasicSimulation<Width, Height>::updateLevel() {
+    // Adjust fall time based on level
+    mFallTime = std::max(0.05f, 0.5f - mLevel * 0.05f);
+
+    if (mScore >= mPointsToNextLevel) {
+        mLevel++;
+        mPointsToNextLevel += POINTS_PER_LEVEL;
+    }
+}
+
+template <int Width, int Height>
+int BasicSimulation<Width, Height>::lock() {
+    Cell position = mCurrentTetromino.getPosition();
+    const Orientation& orientation = mCurrentTetromino.getOrientation();
+    // Upward kicks can lift a piece past the top row, where its cells would be lost
+    bool lockedOut = position.y + orientation.min.y < 0;
+    int color = mCurrentTetromino.getType() + 1; // Use type + 1 as color ID
+    mBoard.place(orientation.rows, position.x, position.y, color);
+
+    int linesCleared;
+    {
+        ProfileScope probe("clearFullLines");
+        linesCleared = mBoard.clearFullLines();
+    }
+    mLinesCleared += linesCleared;
+    mScore += POINTS_PER_LINE * linesCleared;
+    mLastLock = LockResult{mCurrentTetromino.getType(), mNextTetromino.getType(),
+                           Placement{position.x, position.y, mCurrentTetromino.getRotation()},
+                           linesCleared, POINTS_PER_LINE * linesCleared, false};
+
+    spawnTetromino();
+    if (lockedOut || checkCollision(mCurrentTetromino, 0, 0)) { // Or the stack reached the spawn point
+        mLastLock.lostLife = true;
+        mLives--;
+        if (mLives > 0) {
+            mBoard.clear(); // Continue on an empty board
+        } else {
+            mGameOver = true;
+        }
+    }
+    return linesCleared;
+}
+
+template <int Width, int Height>
+int BasicSimulation<Width, Height>::place(const Placement& placement) {
+    if (placement.rotation < 0 || placement.rotation >= Tetromino::ROTATION_COUNT) {
+        return -1;
+    }
+    Tetromino target = mCurrentTetromino;
+    Cell position = target.getPosition();
+    target.setRotation(placement.rotation);
+    target.move(placement.x - position.x, placement.y - position.y);
+    if (checkCollision(target, 0, 0)) {
+        return -1;
+    }
+
+    mCurrentTetromino = target;
+    return lock();
+}
+
+template <int Width, int Height>
+int BasicSimulation<Width, Height>::hardDrop() {
+    mCurrentTetromino.move(0, getDropDistance());
+    mTimeSinceLastFall = 0.0f; // The next piece gets a full fall time
+    return lock();
+}
+
+template <int Width, int Height>
+bool BasicSimulation<Width, Height>::move(int dx, int dy) {
+    if (checkCollision(mCurrentTetromino, dx, dy)) {
+        return false;
+    }
+    mCurrentTetromino.move(dx, dy);
+    return true;
+}
+
+template <int Width, int Height>
+bool BasicSimulation<Width, Height>::rotate() {
+    Tetromino rotated = mCurrentTetromino;
+    rotated.setRotation(Tetromino::nextRotation(rotated.getRotation()));
+
+    // Try the kick offsets in order and keep the first one that fits
+    for (const Cell& kick : mCurrentTetromino.getKicks()) {
+        if (!checkCollision(rotated, kick.x, kick.y)) {
+            rotated.move(kick.x, kick.y);
+            mCurrentTetromino = rotated;
+            return true;
+        }
+    }
+    return false;
+}
+
+template <int Width, int Height>
+bool BasicSimulation<Width, Height>::checkCollision(const Tetromino& tetromino, int offsetX, int offsetY) const {
+    Cell position = tetromino.getPosition();
+    return mBoard.collides(tetromino.getOrientation().rows, position.x + offsetX, position.y + offsetY);
+}
+
+template <int Width, int Height>
+int BasicSimulation<Width, Height>::getDropDistance() const {
+    const Orientation& orientation = mCurrentTetromino.getOrientation();
+    Cell position = mCurrentTetromino.getPosition();
+    return mBoard.dropDistance(orientation.rows, orientation.bottoms, position.x, position.y);
+}
+
+template <int Width, int Height>
+void BasicSimulation<Width, Height>::saveState(std::vector<std::uint8_t>& out) const {
+    std::size_t start = out.size();
+    out.resize(start + SavedGameFormat::size(Width, Height));
+    std::uint8_t* bytes = out.data() + start;
+
+    std::memcpy(bytes, SavedGameFormat::MAGIC, 4);
+    putLittleEndian(bytes + 4, SavedGameFormat::VERSION, 2);
+    bytes[6] = static_cast<std::uint8_t>(Width);
+    bytes[7] = static_cast<std::uint8_t>(Height);
+    putLittleEndian(bytes + 8, mSeed, 8);
+    putLittleEndian(bytes + 16, mRandom.getState(), 8);
+    putLittleEndian(bytes + 24, floatBits(mFallTime), 4);
+    putLittleEndian(bytes + 28, floatBits(mTimeSinceLastFall), 4);
+    putLittleEndian(bytes + 32, static_cast<std::uint32_t>(mScore), 4);
+    putLittleEndian(bytes + 36, static_cast<std::uint32_t>(mLevel), 4);
+    putLittleEndian(bytes + 40, static_cast<std::uint32_t>(mLinesCleared), 4);
+    putLittleEndian(bytes + 44, static_cast<std::uint32_t>(mPointsToNextLevel), 4);
+    putLittleEndian(bytes + 48, static_cast<std::uint32_t>(mLives), 4);
+    putLittleEndian(bytes + 52, static_cast<std::uint32_t>(mPieceCount), 4);
+    bytes[56] = mGameOver ? 1 : 0;
+    bytes[57] = static_cast<std::uint8_t>(mCurrentTetromino.getType());
+    bytes[58] = static_cast<std::uint8_t>(mCurrentTetromino.getRotation());
+    bytes[59] = static_cast<std::uint8_t>(mNextTetromino.getType());
+    Cell position = mCurrentTetromino.getPosition();
+    putLittleEndian(bytes + 60, static_cast<std::uint16_t>(position.x), 2);
+    putLittleEndian(bytes + 62, static_cast<std::uint16_t>(position.y), 2);
+
+    // The color plane is stored row after row, so it packs in one pass
+    const std::uint8_t* colors = mBoard.getRowColors(0);
+    std::uint8_t* cells = bytes + SavedGameFormat::HEADER_SIZE + SavedGameFormat::FIELDS_SIZE;
+    for (int i = 0; i + 1 < Width * Height; i += 2) {
+        cells[i / 2] = static_cast<std::uint8_t>(colors[i] | (colors[i + 1] << 4));
+    }
+    if ((Width * Height) % 2 != 0) {
+        cells[Width * Height / 2] = colors[Width * Height - 1];
+    }
+}
+
+template <int Width, int Height>
+bool BasicSimulation<Width, Height>::loadState(const std::uint8_t* data, std::size_t size) {
+    if (size < SavedGameFormat::size(Width, Height) || std::memcmp(data, SavedGameFormat::MAGIC, 4) != 0 ||
+        getLittleEndian(data + 4, 2) != SavedGameFormat::VERSION || data[6] != Width || data[7] != Height) {
+        return false;
+    }
+    int type = data[57];
+    int rotation = data[58];
+    int nextType = data[59];
+    if (type >= TetrominoTables::TYPE_COUNT || rotation >= Tetromino::ROTATION_COUNT ||
+        nextType >= TetrominoTables::TYPE_COUNT) {
+        return false;
+    }
+    std::array<std::uint8_t, Width * Height> colors;
+    const std::uint8_t* cells = data + SavedGameFormat::HEADER_SIZE + SavedGameFormat::FIELDS_SIZE;
+    std::uint8_t highest = 0;
+    for (int i = 0; i < Width * Height; ++i) {
+        std::uint8_t color = static_cast<std::uint8_t>((cells[i / 2] >> (4 * (i % 2))) & 0x0F);
+        colors[i] = color;
+        highest = color > highest ? color : highest;
+    }
+    if (highest > TetrominoTables::TYPE_COUNT) {
+        return false;
+    }
+
+    // Fill in a copy, so a rejected state leaves this game untouched
+    BasicSimulation loaded = *this;
+    loaded.mSeed = getLittleEndian(data + 8, 8);
+    loaded.mRandom = Random(getLittleEndian(data + 16, 8));
+    loaded.mFallTime = bitsToFloat(static_cast<std::uint32_t>(getLittleEndian(data + 24, 4)));
+    loaded.mTimeSinceLastFall = bitsToFloat(static_cast<std::uint32_t>(getLittleEndian(data + 28, 4)));
+    loaded.mScore = getInt32(data + 32);
+    loaded.mLevel = getInt32(data + 36);
+    loaded.mLinesCleared = getInt32(data + 40);
+    loaded.mPointsToNextLevel = getInt32(data + 44);
+    loaded.mLives = getInt32(data + 48);
+    loaded.mPieceCount = getInt32(data + 52);
+    loaded.mGameOver = data[56] != 0;
+    int x = static_cast<std::int16_t>(getLittleEndian(data + 60, 2));
+    int y = static_cast<std::int16_t>(getLittleEndian(data + 62, 2));
+    loaded.mCurrentTetromino = Tetromino(type, x, y);
+    loaded.mCurrentTetromino.setRotation(rotation);
+    loaded.mNextTetromino = Tetromino(nextType, 0, 0);
+    loaded.mBoard.setCells(colors.data());
+
+    // Stats the rules could never produce would leave a game that cannot
+    // fall (a NaN or zero fall time) or cannot end (no lives left)
+    if (!std::isfinite(loaded.mFallTime) || loaded.mFallTime <= 0.0f ||
+        !std::isfinite(loaded.mTimeSinceLastFall) || loaded.mTimeSinceLastFall < 0.0f ||
+        loaded.mLevel < 1 || loaded.mPointsToNextLevel < 1 || loaded.mScore < 0 || loaded.mLinesCleared < 0 ||
+        loaded.mPieceCount < 1 || (!loaded.mGameOver && loaded.mLives < 1)) {
+        return false;
+    }
+    // A running game's piece must fit where it is, or locking it would
+    // write outside the board
+    if (!loaded.mGameOver && loaded.checkCollision(loaded.mCurrentTetromino, 0, 0)) {
+        return false;
+    }
+    *this = loaded;
+    return true;
+}
+
+template class BasicSimulation<10, 20>;
+template class BasicSimulation<20, 20>;
+template class BasicSimulation<10, 40>;
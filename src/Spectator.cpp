@@ -0,0 +1,292 @@
+#include "Spectator.h"
+#include "ByteOrder.h"
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+using Snapshot = SpectatorSnapshot;
+
+constexpr std::size_t PIECE_SIZE = 5;  // Type, rotation, x, y, next type
+constexpr std::size_t STATS_SIZE = 14; // Score, level, lines, lives, game over
+constexpr std::size_t ROW_BYTES = Snapshot::WIDTH / 2;
+constexpr std::size_t KEYFRAME_SIZE = 1 + 4 + 8 + PIECE_SIZE + STATS_SIZE + Snapshot::HEIGHT * ROW_BYTES;
+
+static_assert(Snapshot::WIDTH % 2 == 0, "Rows are packed two cells per byte");
+static_assert(Snapshot::HEIGHT <= 32, "Delta row masks are 32 bits");
+
+// Appends size bytes to out and returns where they start
+std::uint8_t* grow(std::vector<std::uint8_t>& out, std::size_t size) {
+    std::size_t offset = out.size();
+    out.resize(offset + size);
+    return out.data() + offset;
+}
+
+void writeMessageHeader(std::uint8_t* out, std::uint8_t type, std::size_t payloadSize) {
+    out[0] = type;
+    putLittleEndian(out + 1, payloadSize, 2);
+}
+
+void writePiece(std::uint8_t* out, const Snapshot& snapshot) {
+    out[0] = snapshot.pieceType;
+    out[1] = snapshot.pieceRotation;
+    out[2] = static_cast<std::uint8_t>(snapshot.pieceX);
+    out[3] = static_cast<std::uint8_t>(snapshot.pieceY);
+    out[4] = snapshot.nextType;
+}
+
+void readPiece(const std::uint8_t* in, Snapshot& snapshot) {
+    snapshot.pieceType = in[0];
+    snapshot.pieceRotation = in[1];
+    snapshot.pieceX = static_cast<std::int8_t>(in[2]);
+    snapshot.pieceY = static_cast<std::int8_t>(in[3]);
+    snapshot.nextType = in[4];
+}
+
+bool samePiece(const Snapshot& a, const Snapshot& b) {
+    return a.pieceType == b.pieceType && a.pieceRotation == b.pieceRotation && a.pieceX == b.pieceX &&
+           a.pieceY == b.pieceY && a.nextType == b.nextType;
+}
+
+void writeStats(std::uint8_t* out, const Snapshot& snapshot) {
+    putLittleEndian(out, static_cast<std::uint32_t>(snapshot.score), 4);
+    putLittleEndian(out + 4, static_cast<std::uint32_t>(snapshot.level), 4);
+    putLittleEndian(out + 8, static_cast<std::uint32_t>(snapshot.linesCleared), 4);
+    out[12] = static_cast<std::uint8_t>(snapshot.lives);
+    out[13] = snapshot.gameOver ? 1 : 0;
+}
+
+void readStats(const std::uint8_t* in, Snapshot& snapshot) {
+    snapshot.score = static_cast<std::int32_t>(getLittleEndian(in, 4));
+    snapshot.level = static_cast<std::int32_t>(getLittleEndian(in + 4, 4));
+    snapshot.linesCleared = static_cast<std::int32_t>(getLittleEndian(in + 8, 4));
+    snapshot.lives = in[12];
+    snapshot.gameOver = in[13] != 0;
+}
+
+bool sameStats(const Snapshot& a, const Snapshot& b) {
+    return a.score == b.score && a.level == b.level && a.linesCleared == b.linesCleared && a.lives == b.lives &&
+           a.gameOver == b.gameOver;
+}
+
+void writeRow(std::uint8_t* out, const Snapshot& snapshot, int y) {
+    const std::uint8_t* cells = &snapshot.cells[y * Snapshot::WIDTH];
+    for (std::size_t i = 0; i < ROW_BYTES; ++i) {
+        out[i] = static_cast<std::uint8_t>((cells[2 * i] & 0x0F) | (cells[2 * i + 1] << 4));
+    }
+}
+
+void readRow(const std::uint8_t* in, Snapshot& snapshot, int y) {
+    std::uint8_t* cells = &snapshot.cells[y * Snapshot::WIDTH];
+    for (std::size_t i = 0; i < ROW_BYTES; ++i) {
+        cells[2 * i] = in[i] & 0x0F;
+        cells[2 * i + 1] = static_cast<std::uint8_t>(in[i] >> 4);
+    }
+}
+
+bool sameRow(const Snapshot& a, const Snapshot& b, int y) {
+    return std::equal(a.cells.begin() + y * Snapshot::WIDTH, a.cells.begin() + (y + 1) * Snapshot::WIDTH,
+                      b.cells.begin() + y * Snapshot::WIDTH);
+}
+
+} // namespace
+
+SpectatorSnapshot SpectatorSnapshot::capture(const Simulation& simulation, std::uint32_t tick) {
+    SpectatorSnapshot snapshot;
+    snapshot.tick = tick;
+    snapshot.seed = simulation.getSeed();
+    snapshot.score = simulation.getScore();
+    snapshot.level = simulation.getLevel();
+    snapshot.linesCleared = simulation.getLinesCleared();
+    snapshot.lives = simulation.getLives();
+    snapshot.gameOver = simulation.isGameOver();
+
+    const Tetromino& current = simulation.getCurrentTetromino();
+    snapshot.pieceType = static_cast<std::uint8_t>(current.getType());
+    snapshot.pieceRotation = static_cast<std::uint8_t>(current.getRotation());
+    snapshot.pieceX = static_cast<std::int8_t>(current.getPosition().x);
+    snapshot.pieceY = static_cast<std::int8_t>(current.getPosition().y);
+    snapshot.nextType = static_cast<std::uint8_t>(simulation.getNextTetromino().getType());
+
+    const Simulation::BoardType& board = simulation.getBoard();
+    for (int y = 0; y < HEIGHT; ++y) {
+        std::copy_n(board.getRowColors(y), WIDTH, snapshot.cells.begin() + y * WIDTH);
+    }
+    return snapshot;
+}
+
+bool SpectatorSnapshot::operator==(const SpectatorSnapshot& other) const {
+    return seed == other.seed && sameStats(*this, other) && samePiece(*this, other) &&
+           cells == other.cells;
+}
+
+void SpectatorFormat::writeStreamHeader(std::vector<std::uint8_t>& out) {
+    std::uint8_t* header = grow(out, STREAM_HEADER_SIZE);
+    std::memcpy(header, MAGIC, sizeof(MAGIC));
+    putLittleEndian(header + 4, VERSION, 2);
+    header[6] = static_cast<std::uint8_t>(Snapshot::WIDTH);
+    header[7] = static_cast<std::uint8_t>(Snapshot::HEIGHT);
+}
+
+void SpectatorFormat::writeKeyframe(const SpectatorSnapshot& snapshot, std::uint8_t flags, std::vector<std::uint8_t>& out) {
+    std::uint8_t* message = grow(out, MESSAGE_HEADER_SIZE + KEYFRAME_SIZE);
+    writeMessageHeader(message, KEYFRAME, KEYFRAME_SIZE);
+    std::uint8_t* payload = message + MESSAGE_HEADER_SIZE;
+    payload[0] = flags;
+    putLittleEndian(payload + 1, snapshot.tick, 4);
+    putLittleEndian(payload + 5, snapshot.seed, 8);
+    writePiece(payload + 13, snapshot);
+    writeStats(payload + 13 + PIECE_SIZE, snapshot);
+    std::uint8_t* rows = payload + 13 + PIECE_SIZE + STATS_SIZE;
+    for (int y = 0; y < Snapshot::HEIGHT; ++y) {
+        writeRow(rows + y * ROW_BYTES, snapshot, y);
+    }
+}
+
+bool SpectatorFormat::writeDelta(const SpectatorSnapshot& from, const SpectatorSnapshot& to, std::vector<std::uint8_t>& out) {
+    std::uint8_t changed = 0;
+    changed |= samePiece(from, to) ? 0 : DELTA_PIECE;
+    changed |= sameStats(from, to) ? 0 : DELTA_STATS;
+    std::uint32_t rowMask = 0;
+    for (int y = 0; y < Snapshot::HEIGHT; ++y) {
+        rowMask |= sameRow(from, to, y) ? 0u : (1u << y);
+    }
+    if (changed == 0 && rowMask == 0) {
+        return false; // Only the tick moved, which spectators can infer
+    }
+
+    std::size_t rowCount = 0;
+    for (std::uint32_t bits = rowMask; bits; bits &= bits - 1) {
+        rowCount++;
+    }
+    std::size_t payloadSize = 4 + 1 + ((changed & DELTA_PIECE) ? PIECE_SIZE : 0) +
+                              ((changed & DELTA_STATS) ? STATS_SIZE : 0) + 4 + rowCount * ROW_BYTES;
+    std::uint8_t* message = grow(out, MESSAGE_HEADER_SIZE + payloadSize);
+    writeMessageHeader(message, DELTA, payloadSize);
+    std::uint8_t* cursor = message + MESSAGE_HEADER_SIZE;
+    putLittleEndian(cursor, to.tick, 4);
+    cursor[4] = changed;
+    cursor += 5;
+    if (changed & DELTA_PIECE) {
+        writePiece(cursor, to);
+        cursor += PIECE_SIZE;
+    }
+    if (changed & DELTA_STATS) {
+        writeStats(cursor, to);
+        cursor += STATS_SIZE;
+    }
+    putLittleEndian(cursor, rowMask, 4);
+    cursor += 4;
+    for (int y = 0; y < Snapshot::HEIGHT; ++y) {
+        if (rowMask & (1u << y)) {
+            writeRow(cursor, to, y);
+            cursor += ROW_BYTES;
+        }
+    }
+    return true;
+}
+
+bool SpectatorDecoder::feed(const std::uint8_t* data, std::size_t size) {
+    if (mFailed) {
+        return false;
+    }
+    mPending.insert(mPending.end(), data, data + size);
+
+    std::size_t offset = 0;
+    if (!mHeaderRead) {
+        if (mPending.size() < SpectatorFormat::STREAM_HEADER_SIZE) {
+            return true;
+        }
+        const std::uint8_t* header = mPending.data();
+        if (std::memcmp(header, SpectatorFormat::MAGIC, sizeof(SpectatorFormat::MAGIC)) != 0 ||
+            getLittleEndian(header + 4, 2) != SpectatorFormat::VERSION ||
+            header[6] != SpectatorSnapshot::WIDTH || header[7] != SpectatorSnapshot::HEIGHT) {
+            mFailed = true;
+            return false;
+        }
+        mHeaderRead = true;
+        offset = SpectatorFormat::STREAM_HEADER_SIZE;
+    }
+
+    while (mPending.size() - offset >= SpectatorFormat::MESSAGE_HEADER_SIZE) {
+        const std::uint8_t* message = mPending.data() + offset;
+        std::size_t payloadSize = static_cast<std::size_t>(getLittleEndian(message + 1, 2));
+        if (mPending.size() - offset < SpectatorFormat::MESSAGE_HEADER_SIZE + payloadSize) {
+            break; // The rest has not arrived yet
+        }
+        if (!decodeMessage(message[0], message + SpectatorFormat::MESSAGE_HEADER_SIZE, payloadSize)) {
+            mFailed = true;
+            return false;
+        }
+        offset += SpectatorFormat::MESSAGE_HEADER_SIZE + payloadSize;
+    }
+    mPending.erase(mPending.begin(), mPending.begin() + static_cast<std::ptrdiff_t>(offset));
+    return true;
+}
+
+bool SpectatorDecoder::decodeMessage(std::uint8_t type, const std::uint8_t* payload, std::size_t size) {
+    if (type == SpectatorFormat::KEYFRAME) {
+        if (size != KEYFRAME_SIZE) {
+            return false;
+        }
+        SpectatorSnapshot snapshot;
+        snapshot.tick = static_cast<std::uint32_t>(getLittleEndian(payload + 1, 4));
+        snapshot.seed = getLittleEndian(payload + 5, 8);
+        readPiece(payload + 13, snapshot);
+        readStats(payload + 13 + PIECE_SIZE, snapshot);
+        const std::uint8_t* rows = payload + 13 + PIECE_SIZE + STATS_SIZE;
+        for (int y = 0; y < Snapshot::HEIGHT; ++y) {
+            readRow(rows + y * ROW_BYTES, snapshot, y);
+        }
+        if ((payload[0] & SpectatorFormat::KEYFRAME_CHECKPOINT) && mHasSnapshot && snapshot != mSnapshot) {
+            mMismatches++;
+        }
+        mSnapshot = snapshot;
+        mHasSnapshot = true;
+        mKeyframes++;
+        return true;
+    }
+
+    if (type == SpectatorFormat::DELTA) {
+        if (!mHasSnapshot || size < 9) {
+            return false; // A delta needs a keyframe to apply to
+        }
+        std::uint8_t changed = payload[4];
+        std::size_t expected = 4 + 1 + ((changed & SpectatorFormat::DELTA_PIECE) ? PIECE_SIZE : 0) +
+                               ((changed & SpectatorFormat::DELTA_STATS) ? STATS_SIZE : 0) + 4;
+        if (size < expected) {
+            return false;
+        }
+        // Decoded into a copy, so a malformed delta leaves the mirror untouched
+        const std::uint8_t* cursor = payload + 5;
+        SpectatorSnapshot snapshot = mSnapshot;
+        snapshot.tick = static_cast<std::uint32_t>(getLittleEndian(payload, 4));
+        if (changed & SpectatorFormat::DELTA_PIECE) {
+            readPiece(cursor, snapshot);
+            cursor += PIECE_SIZE;
+        }
+        if (changed & SpectatorFormat::DELTA_STATS) {
+            readStats(cursor, snapshot);
+            cursor += STATS_SIZE;
+        }
+        std::uint32_t rowMask = static_cast<std::uint32_t>(getLittleEndian(cursor, 4));
+        cursor += 4;
+        std::size_t rowCount = 0;
+        for (std::uint32_t bits = rowMask; bits; bits &= bits - 1) {
+            rowCount++;
+        }
+        if (size != expected + rowCount * ROW_BYTES || (rowMask >> (Snapshot::HEIGHT - 1)) > 1) {
+            return false;
+        }
+        for (int y = 0; y < Snapshot::HEIGHT; ++y) {
+            if (rowMask & (1u << y)) {
+                readRow(cursor, snapshot, y);
+                cursor += ROW_BYTES;
+            }
+        }
+        mSnapshot = snapshot;
+        mDeltas++;
+        return true;
+    }
+    return false;
+}
@@ -0,0 +1,232 @@
+#include "SpectatorServer.h"
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#define TETRIS_HAS_SOCKETS 1
+#endif
+
+#ifdef TETRIS_HAS_SOCKETS
+
+namespace {
+
+#ifdef MSG_NOSIGNAL
+constexpr int SEND_FLAGS = MSG_NOSIGNAL; // A closed client must not raise SIGPIPE
+#else
+constexpr int SEND_FLAGS = 0; // SO_NOSIGPIPE is set on each socket instead
+#endif
+
+bool setNonBlocking(int fd) {
+    int flags = fcntl(fd, F_GETFL, 0);
+    return flags >= 0 && fcntl(fd, F_SETFL, flags | O_NONBLOCK) == 0;
+}
+
+} // namespace
+
+SpectatorServer::~SpectatorServer() {
+    close();
+}
+
+bool SpectatorServer::listenTcp(std::uint16_t port) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) {
+        return false;
+    }
+    int reuse = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+    sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(port);
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 || listen(fd, 16) != 0 ||
+        !setNonBlocking(fd)) {
+        std::cerr << "Spectator server: cannot listen on port " << port << ": " << std::strerror(errno) << std::endl;
+        ::close(fd);
+        return false;
+    }
+    mListeners.push_back(fd);
+    return true;
+}
+
+bool SpectatorServer::listenUnix(const std::string& path) {
+    sockaddr_un address = {};
+    if (path.size() >= sizeof(address.sun_path)) {
+        std::cerr << "Spectator server: socket path too long: " << path << std::endl;
+        return false;
+    }
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+        return false;
+    }
+    address.sun_family = AF_UNIX;
+    std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+    unlink(path.c_str()); // Left behind by a previous run
+    if (bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 || listen(fd, 16) != 0 ||
+        !setNonBlocking(fd)) {
+        std::cerr << "Spectator server: cannot listen on " << path << ": " << std::strerror(errno) << std::endl;
+        ::close(fd);
+        return false;
+    }
+    mListeners.push_back(fd);
+    mUnixPath = path;
+    return true;
+}
+
+void SpectatorServer::close() {
+    for (const Client& client : mClients) {
+        ::close(client.fd);
+    }
+    mClients.clear();
+    for (int fd : mListeners) {
+        ::close(fd);
+    }
+    mListeners.clear();
+    if (!mUnixPath.empty()) {
+        unlink(mUnixPath.c_str());
+        mUnixPath.clear();
+    }
+}
+
+void SpectatorServer::acceptClients() {
+    for (int listener : mListeners) {
+        for (;;) {
+            int fd = accept(listener, nullptr, nullptr);
+            if (fd < 0) {
+                break; // EAGAIN: no one else is waiting
+            }
+            if (!setNonBlocking(fd)) {
+                ::close(fd);
+                continue;
+            }
+            int one = 1;
+            setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one)); // Fails harmlessly on Unix sockets
+#ifdef SO_NOSIGPIPE
+            setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &one, sizeof(one));
+#endif
+            Client client{fd, {}, 0, true};
+            SpectatorFormat::writeStreamHeader(client.pending);
+            mClients.push_back(std::move(client));
+        }
+    }
+}
+
+bool SpectatorServer::flush(Client& client) {
+    // One write per publish with everything queued, however many messages
+    // that is; whatever the socket does not take waits for the next publish
+    std::size_t remaining = client.pending.size() - client.offset;
+    if (remaining > 0) {
+        ssize_t sent = send(client.fd, client.pending.data() + client.offset, remaining, SEND_FLAGS);
+        if (sent < 0) {
+            if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+                return false;
+            }
+        } else {
+            client.offset += static_cast<std::size_t>(sent);
+        }
+    }
+
+    if (client.offset == client.pending.size()) {
+        client.pending.clear();
+        client.offset = 0;
+    } else if (client.offset > client.pending.size() / 2) {
+        client.pending.erase(client.pending.begin(), client.pending.begin() + static_cast<std::ptrdiff_t>(client.offset));
+        client.offset = 0;
+    }
+    return true;
+}
+
+void SpectatorServer::publish(const SpectatorSnapshot& snapshot) {
+    acceptClients();
+
+    bool newGame = !mHasLast || snapshot.seed != mLast.seed || snapshot.tick < mLast.tick;
+    bool checkpoint = ++mSinceKeyframe >= KEYFRAME_INTERVAL;
+    if (checkpoint) {
+        mSinceKeyframe = 0;
+    }
+
+    if (!mClients.empty()) {
+        mDelta.clear();
+        bool hasDelta = !newGame && SpectatorFormat::writeDelta(mLast, snapshot, mDelta);
+        mKeyframe.clear();
+        auto appendKeyframe = [&](Client& client, std::uint8_t flags) {
+            if (mKeyframe.empty()) {
+                SpectatorFormat::writeKeyframe(snapshot, 0, mKeyframe);
+            }
+            std::size_t start = client.pending.size();
+            client.pending.insert(client.pending.end(), mKeyframe.begin(), mKeyframe.end());
+            client.pending[start + SpectatorFormat::MESSAGE_HEADER_SIZE] = flags;
+        };
+
+        for (Client& client : mClients) {
+            bool lagging = client.pending.size() - client.offset >= MAX_BACKLOG;
+            if (newGame || client.needsKeyframe || lagging) {
+                // Skip deltas until the backlog drains, then start over from a keyframe
+                client.needsKeyframe = lagging;
+                if (!lagging) {
+                    appendKeyframe(client, 0);
+                }
+            } else {
+                if (hasDelta) {
+                    client.pending.insert(client.pending.end(), mDelta.begin(), mDelta.end());
+                }
+                if (checkpoint) {
+                    appendKeyframe(client, SpectatorFormat::KEYFRAME_CHECKPOINT);
+                }
+            }
+        }
+
+        // Drop the clients that hung up
+        for (std::size_t i = 0; i < mClients.size();) {
+            if (flush(mClients[i])) {
+                ++i;
+                continue;
+            }
+            ::close(mClients[i].fd);
+            if (i + 1 < mClients.size()) {
+                mClients[i] = std::move(mClients.back());
+            }
+            mClients.pop_back();
+        }
+    }
+
+    mLast = snapshot;
+    mHasLast = true;
+}
+
+#else // No sockets on this platform: spectating is unavailable
+
+SpectatorServer::~SpectatorServer() = default;
+
+bool SpectatorServer::listenTcp(std::uint16_t) {
+    std::cerr << "Spectator server: not supported on this platform" << std::endl;
+    return false;
+}
+
+bool SpectatorServer::listenUnix(const std::string&) {
+    std::cerr << "Spectator server: not supported on this platform" << std::endl;
+    return false;
+}
+
+void SpectatorServer::close() {
+}
+
+void SpectatorServer::acceptClients() {
+}
+
+bool SpectatorServer::flush(Client&) {
+    return false;
+}
+
+void SpectatorServer::publish(const SpectatorSnapshot&) {
+}
+
+#endif
@@ -0,0 +1,112 @@
+#include "TerminalScreen.h"
+#include <algorithm>
+
+namespace {
+
+void appendNumber(std::string& out, int value) {
+    char digits[12];
+    int count = 0;
+    do {
+        digits[count++] = static_cast<char>('0' + value % 10);
+        value /= 10;
+    } while (value > 0);
+    while (count > 0) {
+        out += digits[--count];
+    }
+}
+
+void appendColor(std::string& out, std::int16_t color, const char* defaultCode, const char* paletteCode) {
+    if (color == TerminalScreen::DEFAULT_COLOR) {
+        out += defaultCode;
+    } else {
+        out += paletteCode;
+        appendNumber(out, color);
+    }
+}
+
+} // namespace
+
+TerminalScreen::TerminalScreen(int columns, int rows)
+    : mColumns(columns),
+      mRows(rows),
+      mBack(static_cast<std::size_t>(columns * rows)),
+      mShown(static_cast<std::size_t>(columns * rows)),
+      mShownValid(false)
+{
+    clear();
+}
+
+void TerminalScreen::clear() {
+    std::fill(mBack.begin(), mBack.end(), Cell{' ', DEFAULT_COLOR, DEFAULT_COLOR});
+}
+
+void TerminalScreen::put(int x, int y, char ch, std::int16_t fg, std::int16_t bg) {
+    if (x < 0 || x >= mColumns || y < 0 || y >= mRows) {
+        return;
+    }
+    mBack[y * mColumns + x] = Cell{ch, fg, bg};
+}
+
+void TerminalScreen::text(int x, int y, const char* str, std::int16_t fg) {
+    for (; *str; ++str, ++x) {
+        put(x, y, *str, fg);
+    }
+}
+
+void TerminalScreen::invalidate() {
+    mShownValid = false;
+}
+
+void TerminalScreen::present(std::string& out) {
+    if (!mShownValid) {
+        // Clear the terminal; then only the non-blank cells need writing
+        out += "\x1b[0m\x1b[2J";
+        std::fill(mShown.begin(), mShown.end(), Cell{' ', DEFAULT_COLOR, DEFAULT_COLOR});
+        mShownValid = true;
+    }
+
+    // Where the cursor and the pen are; unknown until the first write
+    int cursorX = -1;
+    int cursorY = -1;
+    bool penKnown = false;
+    std::int16_t penFg = DEFAULT_COLOR;
+    std::int16_t penBg = DEFAULT_COLOR;
+
+    for (int y = 0; y < mRows; ++y) {
+        for (int x = 0; x < mColumns; ++x) {
+            const Cell& cell = mBack[y * mColumns + x];
+            Cell& shown = mShown[y * mColumns + x];
+            if (cell == shown) {
+                continue;
+            }
+            if (x != cursorX || y != cursorY) {
+                out += "\x1b[";
+                appendNumber(out, y + 1);
+                out += ';';
+                appendNumber(out, x + 1);
+                out += 'H';
+            }
+            // A blank shows only its background, so any foreground will do
+            bool fgMatters = cell.ch != ' ';
+            if (!penKnown || (fgMatters && cell.fg != penFg) || cell.bg != penBg) {
+                out += "\x1b[";
+                appendColor(out, cell.fg, "39", "38;5;");
+                out += ';';
+                appendColor(out, cell.bg, "49", "48;5;");
+                out += 'm';
+                penKnown = true;
+                penFg = cell.fg;
+                penBg = cell.bg;
+            }
+            out += cell.ch;
+            shown = cell;
+            cursorX = x + 1;
+            cursorY = y;
+        }
+    }
+}
+
+std::int16_t TerminalScreen::toPaletteColor(const Rgb& rgb) {
+    auto level = [](std::uint8_t component) { return (component * 5 + 127) / 255; };
+    return static_cast<std::int16_t>(16 + 36 * level(rgb.r) + 6 * level(rgb.g) + level(rgb.b));
+}
@@ -0,0 +1,210 @@
+#include "TrainingData.h"
+#include "ByteOrder.h"
+#include <cstring>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#define TETRIS_HAS_MMAP 1
+#endif
+
+namespace {
+
+using namespace TrainingDataFormat;
+
+constexpr std::array<std::size_t, COLUMNS.size()> makeColumnOffsets() {
+    std::array<std::size_t, COLUMNS.size()> offsets = {};
+    std::size_t offset = 0;
+    for (std::size_t i = 0; i < COLUMNS.size(); ++i) {
+        offsets[i] = offset;
+        offset += CHUNK_ROWS * COLUMNS[i].width;
+    }
+    return offsets;
+}
+
+constexpr std::array<std::size_t, COLUMNS.size()> COLUMN_OFFSETS = makeColumnOffsets();
+
+enum ColumnIndex { BOARD, PIECE, NEXT, X, Y, ROTATION, LINES, SCORE_DELTA, LOST_LIFE, GAME, SEED };
+
+} // namespace
+
+TrainingRecord TrainingRecord::make(const Board& before, const LockResult& lock) {
+    TrainingRecord record;
+    record.board.fill(0);
+    for (int y = 0; y < Board::HEIGHT; ++y) {
+        Board::Row row = before.getRow(y);
+        for (int x = 0; row; ++x, row = static_cast<Board::Row>(row >> 1)) {
+            if (row & 1u) {
+                int bit = y * Board::WIDTH + x;
+                record.board[bit / 8] = static_cast<std::uint8_t>(record.board[bit / 8] | (1u << (bit % 8)));
+            }
+        }
+    }
+    record.lock = lock;
+    return record;
+}
+
+TrainingDataWriter::~TrainingDataWriter() {
+    close();
+}
+
+bool TrainingDataWriter::open(const std::string& path) {
+    close();
+    mChunkIndex = 0;
+    mChunkRows = 0;
+    mRowCount = 0;
+    mGameCount = 0;
+    mFailed = false;
+
+#ifdef TETRIS_HAS_MMAP
+    mFd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (mFd < 0) {
+        return false;
+    }
+#else
+    mFile.open(path, std::ios::in | std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!mFile.is_open()) {
+        return false;
+    }
+#endif
+    if (!writeHeader() || !beginChunk()) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+bool TrainingDataWriter::append(const TrainingRecord* records, std::size_t count, std::uint64_t seed) {
+    std::lock_guard<std::mutex> lock(mMutex);
+    if (!mChunk) {
+        return false; // Not open, or an earlier chunk failed
+    }
+    std::uint32_t game = static_cast<std::uint32_t>(mGameCount++);
+    for (std::size_t i = 0; i < count; ++i) {
+        if (mChunkRows == CHUNK_ROWS && (!endChunk() || !beginChunk())) {
+            mFailed = true;
+            return false;
+        }
+        writeRow(mChunkRows++, records[i], game, seed);
+        mRowCount++;
+    }
+    return true;
+}
+
+void TrainingDataWriter::writeRow(std::size_t row, const TrainingRecord& record, std::uint32_t game,
+                                  std::uint64_t seed) {
+    std::uint8_t* chunk = mChunk;
+    const LockResult& lock = record.lock;
+    std::memcpy(chunk + COLUMN_OFFSETS[BOARD] + row * BOARD_BYTES, record.board.data(), BOARD_BYTES);
+    chunk[COLUMN_OFFSETS[PIECE] + row] = static_cast<std::uint8_t>(lock.type);
+    chunk[COLUMN_OFFSETS[NEXT] + row] = static_cast<std::uint8_t>(lock.nextType);
+    chunk[COLUMN_OFFSETS[X] + row] = static_cast<std::uint8_t>(lock.placement.x);
+    chunk[COLUMN_OFFSETS[Y] + row] = static_cast<std::uint8_t>(lock.placement.y);
+    chunk[COLUMN_OFFSETS[ROTATION] + row] = static_cast<std::uint8_t>(lock.placement.rotation);
+    chunk[COLUMN_OFFSETS[LINES] + row] = static_cast<std::uint8_t>(lock.linesCleared);
+    putLittleEndian(chunk + COLUMN_OFFSETS[SCORE_DELTA] + row * 4, static_cast<std::uint32_t>(lock.scoreDelta), 4);
+    chunk[COLUMN_OFFSETS[LOST_LIFE] + row] = lock.lostLife ? 1 : 0;
+    putLittleEndian(chunk + COLUMN_OFFSETS[GAME] + row * 4, game, 4);
+    putLittleEndian(chunk + COLUMN_OFFSETS[SEED] + row * 8, seed, 8);
+}
+
+bool TrainingDataWriter::beginChunk() {
+    std::uint64_t offset = HEADER_SIZE + mChunkIndex * CHUNK_BYTES;
+#ifdef TETRIS_HAS_MMAP
+    // Grow the file first: the new chunk reads as zeros and takes no disk
+    // space until it is written
+    if (ftruncate(mFd, static_cast<off_t>(offset + CHUNK_BYTES)) != 0) {
+        return false;
+    }
+    // Mappings start on a page boundary, and pages are 4 to 64 KiB, so map
+    // from the start of the page the chunk begins in
+    static const std::uint64_t pageSize = static_cast<std::uint64_t>(sysconf(_SC_PAGESIZE));
+    std::uint64_t mapOffset = offset - offset % pageSize;
+    std::size_t lead = static_cast<std::size_t>(offset - mapOffset);
+    void* address = mmap(nullptr, lead + CHUNK_BYTES, PROT_READ | PROT_WRITE, MAP_SHARED, mFd,
+                         static_cast<off_t>(mapOffset));
+    if (address == MAP_FAILED) {
+        return false;
+    }
+    mMapping = address;
+    mMappingSize = lead + CHUNK_BYTES;
+    mChunk = static_cast<std::uint8_t*>(address) + lead;
+#else
+    (void)offset;
+    mBuffer.assign(CHUNK_BYTES, 0);
+    mChunk = mBuffer.data();
+#endif
+    mChunkRows = 0;
+    return true;
+}
+
+bool TrainingDataWriter::endChunk() {
+    bool ok = true;
+#ifdef TETRIS_HAS_MMAP
+    ok = munmap(mMapping, mMappingSize) == 0;
+    mMapping = nullptr;
+#else
+    mFile.seekp(static_cast<std::streamoff>(HEADER_SIZE + mChunkIndex * CHUNK_BYTES));
+    mFile.write(reinterpret_cast<const char*>(mChunk), static_cast<std::streamsize>(CHUNK_BYTES));
+    ok = mFile.good();
+#endif
+    mChunk = nullptr;
+    mChunkIndex++;
+    return writeHeader() && ok;
+}
+
+bool TrainingDataWriter::writeHeader() {
+    std::uint8_t header[HEADER_SIZE] = {};
+    std::memcpy(header, MAGIC, 4);
+    putLittleEndian(header + 4, VERSION, 2);
+    putLittleEndian(header + 6, COLUMNS.size(), 2);
+    putLittleEndian(header + 8, CHUNK_ROWS, 4);
+    header[12] = static_cast<std::uint8_t>(Board::WIDTH);
+    header[13] = static_cast<std::uint8_t>(Board::HEIGHT);
+    putLittleEndian(header + 16, mRowCount, 8);
+    putLittleEndian(header + 24, mGameCount, 8);
+    putLittleEndian(header + 32, CHUNK_BYTES, 8);
+    for (std::size_t i = 0; i < COLUMNS.size(); ++i) {
+        std::uint8_t* entry = header + 64 + 32 * i;
+        std::memcpy(entry, COLUMNS[i].name, std::strlen(COLUMNS[i].name));
+        putLittleEndian(entry + 16, COLUMNS[i].width, 4);
+        putLittleEndian(entry + 20, COLUMN_OFFSETS[i], 4);
+    }
+
+#ifdef TETRIS_HAS_MMAP
+    return pwrite(mFd, header, HEADER_SIZE, 0) == static_cast<ssize_t>(HEADER_SIZE);
+#else
+    mFile.seekp(0);
+    mFile.write(reinterpret_cast<const char*>(header), HEADER_SIZE);
+    return mFile.good();
+#endif
+}
+
+bool TrainingDataWriter::close() {
+    std::lock_guard<std::mutex> lock(mMutex);
+#ifdef TETRIS_HAS_MMAP
+    if (mFd < 0) {
+        return !mFailed;
+    }
+#else
+    if (!mFile.is_open()) {
+        return !mFailed;
+    }
+#endif
+    // The partial last chunk keeps its full size, so its columns stay at
+    // the same offsets as every other chunk's
+    if (mChunk) {
+        mFailed = !endChunk() || mFailed;
+    } else {
+        mFailed = !writeHeader() || mFailed;
+    }
+#ifdef TETRIS_HAS_MMAP
+    ::close(mFd);
+    mFd = -1;
+#else
+    mFile.close();
+#endif
+    mBuffer = std::vector<std::uint8_t>();
+    return !mFailed;
+}
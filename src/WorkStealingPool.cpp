@@ -0,0 +1,110 @@
+#include "WorkStealingPool.h"
+
+namespace {
+// Lets submit() recognise calls made from inside one of the pool's tasks
+thread_local const WorkStealingPool* tCurrentPool = nullptr;
+thread_local unsigned tWorkerIndex = 0;
+}
+
+WorkStealingPool::WorkStealingPool(unsigned threadCount)
+    : mNextWorker(0),
+      mQueued(0),
+      mPending(0),
+      mStopping(false)
+{
+    if (threadCount == 0) {
+        threadCount = 1;
+    }
+    for (unsigned i = 0; i < threadCount; ++i) {
+        mWorkers.push_back(std::make_unique<Worker>());
+    }
+    for (unsigned i = 0; i < threadCount; ++i) {
+        mThreads.emplace_back(&WorkStealingPool::workerLoop, this, i);
+    }
+}
+
+WorkStealingPool::~WorkStealingPool() {
+    {
+        std::lock_guard<std::mutex> lock(mStateMutex);
+        mStopping = true;
+    }
+    mWorkAvailable.notify_all();
+    for (std::thread& thread : mThreads) {
+        thread.join();
+    }
+}
+
+void WorkStealingPool::submit(std::function<void()> task) {
+    unsigned index = (tCurrentPool == this)
+        ? tWorkerIndex
+        : mNextWorker.fetch_add(1, std::memory_order_relaxed) % mWorkers.size();
+
+    mPending.fetch_add(1);
+    {
+        // Count the task before it becomes visible, so a worker that finds
+        // it never drives mQueued negative
+        std::lock_guard<std::mutex> lock(mStateMutex);
+        mQueued.fetch_add(1);
+    }
+    {
+        std::lock_guard<std::mutex> lock(mWorkers[index]->mutex);
+        mWorkers[index]->tasks.push_back(std::move(task));
+    }
+    mWorkAvailable.notify_one();
+}
+
+void WorkStealingPool::wait() {
+    std::unique_lock<std::mutex> lock(mStateMutex);
+    mAllDone.wait(lock, [this] { return mPending.load() == 0; });
+}
+
+bool WorkStealingPool::popTask(unsigned index, std::function<void()>& task) {
+    {
+        // Newest task from our own deque first, it is the most likely to be cache-warm
+        Worker& own = *mWorkers[index];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.tasks.empty()) {
+            task = std::move(own.tasks.back());
+            own.tasks.pop_back();
+            mQueued.fetch_sub(1);
+            return true;
+        }
+    }
+
+    // Then steal the oldest task of another worker
+    for (std::size_t i = 1; i < mWorkers.size(); ++i) {
+        Worker& victim = *mWorkers[(index + i) % mWorkers.size()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.tasks.empty()) {
+            task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+            mQueued.fetch_sub(1);
+            return true;
+        }
+    }
+    return false;
+}
+
+void WorkStealingPool::workerLoop(unsigned index) {
+    tCurrentPool = this;
+    tWorkerIndex = index;
+
+    std::function<void()> task;
+    while (true) {
+        if (popTask(index, task)) {
+            task();
+            task = nullptr;
+            if (mPending.fetch_sub(1) == 1) {
+                std::lock_guard<std::mutex> lock(mStateMutex);
+                mAllDone.notify_all();
+            }
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(mStateMutex);
+        mWorkAvailable.wait(lock, [this] { return mStopping || mQueued.load() > 0; });
+        if (mStopping && mQueued.load() == 0) {
+            return;
+        }
+    }
+}
@@ -1,8 +1,83 @@
 #include "Game.h"
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
 
-int main()
+static void printUsage(const char* program) {
+    std::cerr << "Usage: " << program << " [options]\n"
+              << "  --tick-rate N     Simulation ticks per second (default 60)\n"
+              << "  --fps N           Frame rate limit, 0 for none (default 60)\n"
+              << "  --vsync           Enable vertical sync\n"
+              << "  --pacing-stats    Print frame pacing counters once per second\n"
+              << "  --record DIR      Save a replay of every game in DIR\n"
+              << "  --replay FILE     Watch a recorded game\n"
+              << "  --speed N         Replay at N times real time (default 1)\n"
+              << "  --profile         Start with the profiler overlay on (toggle with F3)\n"
+              << "  --trace FILE      Chrome trace written by F4 and on exit while profiling\n"
+              << "  --scores FILE     Leaderboard and game stats file (default scores.dat)\n"
+              << "  --das MS          Delay before a held move key repeats (default 167)\n"
+              << "  --arr MS          Time between repeated moves, 0 for instant (default 33)\n"
+              << "  --soft-drop MS    Time between rows while soft dropping (default 33)\n"
+              << "  --spectate-port N Stream the game to spectators on 127.0.0.1:N\n"
+              << "  --spectate-socket PATH  Stream the game to spectators on a Unix socket\n"
+              << "  --save FILE       Where F5 saves the game and F9 resumes it (default savegame.dat)\n"
+              << "  --hint            Start with the move hint on (toggle with H)\n"
+              << "  --hint-budget MS  Time the hint search may take per piece (default 5)\n";
+}
+
+int main(int argc, char* argv[])
 {
-    Game game;
+    GameSettings settings;
+    for (int i = 1; i < argc; ++i) {
+        const char* arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (std::strcmp(arg, "--tick-rate") == 0 && hasValue) {
+            settings.tickRate = static_cast<unsigned>(std::atoi(argv[++i]));
+        } else if (std::strcmp(arg, "--fps") == 0 && hasValue) {
+            settings.frameRateLimit = static_cast<unsigned>(std::atoi(argv[++i]));
+        } else if (std::strcmp(arg, "--vsync") == 0) {
+            settings.verticalSync = true;
+        } else if (std::strcmp(arg, "--pacing-stats") == 0) {
+            settings.printPacingStats = true;
+        } else if (std::strcmp(arg, "--record") == 0 && hasValue) {
+            settings.recordDirectory = argv[++i];
+        } else if (std::strcmp(arg, "--replay") == 0 && hasValue) {
+            settings.replayPath = argv[++i];
+        } else if (std::strcmp(arg, "--speed") == 0 && hasValue) {
+            settings.replaySpeed = static_cast<unsigned>(std::atoi(argv[++i]));
+        } else if (std::strcmp(arg, "--profile") == 0) {
+            settings.profile = true;
+        } else if (std::strcmp(arg, "--trace") == 0 && hasValue) {
+            settings.tracePath = argv[++i];
+        } else if (std::strcmp(arg, "--scores") == 0 && hasValue) {
+            settings.scorePath = argv[++i];
+        } else if (std::strcmp(arg, "--das") == 0 && hasValue) {
+            settings.inputTiming.das = static_cast<float>(std::atof(argv[++i])) / 1000.0f;
+        } else if (std::strcmp(arg, "--arr") == 0 && hasValue) {
+            settings.inputTiming.arr = static_cast<float>(std::atof(argv[++i])) / 1000.0f;
+        } else if (std::strcmp(arg, "--soft-drop") == 0 && hasValue) {
+            settings.inputTiming.softDrop = static_cast<float>(std::atof(argv[++i])) / 1000.0f;
+        } else if (std::strcmp(arg, "--spectate-port") == 0 && hasValue) {
+            settings.spectatorPort = static_cast<unsigned>(std::atoi(argv[++i]));
+        } else if (std::strcmp(arg, "--spectate-socket") == 0 && hasValue) {
+            settings.spectatorSocket = argv[++i];
+        } else if (std::strcmp(arg, "--save") == 0 && hasValue) {
+            settings.savePath = argv[++i];
+        } else if (std::strcmp(arg, "--hint") == 0) {
+            settings.hint = true;
+        } else if (std::strcmp(arg, "--hint-budget") == 0 && hasValue) {
+            settings.hintBudget = static_cast<float>(std::atof(argv[++i])) / 1000.0f;
+        } else {
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+    if (settings.tickRate == 0 || settings.replaySpeed == 0) {
+        std::cerr << "--tick-rate and --speed must be at least 1" << std::endl;
+        return 1;
+    }
+
+    Game game(settings);
     game.run();
     return 0;
 }
@@ -0,0 +1,460 @@
+// Microbenchmarks for the simulation hot paths, on fixed seeded board
+// corpora. Results are printed as JSON so they can be compared between
+// releases. Needs no window or GPU. --check-allocations instead verifies that
+// running games allocate nothing on the heap.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <new>
+#include <string>
+#include <vector>
+#include "Board.h"
+#include "BoardBatch.h"
+#include "LookaheadSearch.h"
+#include "PlacementSearch.h"
+#include "Policy.h"
+#include "Profiler.h"
+#include "Random.h"
+#include "Simulation.h"
+#include "UndoStack.h"
+
+// Counts every heap allocation in the process, for --check-allocations
+static std::atomic<long long> gAllocations(0);
+
+void* operator new(std::size_t size) {
+    gAllocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* memory = std::malloc(size ? size : 1)) {
+        return memory;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* memory) noexcept {
+    std::free(memory);
+}
+
+void operator delete(void* memory, std::size_t) noexcept {
+    std::free(memory);
+}
+
+namespace {
+
+struct Options {
+    std::string filter;      // Run only benchmarks whose name contains this
+    std::string outputPath;  // JSON goes to stdout when empty
+    double minTime = 0.2;    // Seconds per repetition
+    int repetitions = 5;
+    bool checkAllocations = false;
+};
+
+struct Result {
+    std::string name;
+    long long iterations;   // Per repetition
+    double nsPerOp;         // Median over repetitions
+    double minNsPerOp;
+    double maxNsPerOp;
+};
+
+// Keeps benchmark results observable so the compiler cannot drop the work
+volatile std::uint64_t gSink = 0;
+
+// A benchmark body runs the operation `iterations` times
+using Body = std::function<void(long long iterations)>;
+
+Result runBenchmark(const std::string& name, const Body& body, const Options& options) {
+    using Clock = std::chrono::steady_clock;
+
+    // Grow the batch until one run takes long enough to time reliably
+    long long iterations = 1;
+    while (true) {
+        auto start = Clock::now();
+        body(iterations);
+        double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+        if (seconds >= options.minTime || iterations >= (1LL << 40)) {
+            break;
+        }
+        double scale = seconds > 0.0 ? options.minTime / seconds * 1.2 : 10.0;
+        iterations = static_cast<long long>(iterations * std::min(std::max(scale, 1.5), 10.0));
+    }
+
+    std::vector<double> samples;
+    for (int r = 0; r < options.repetitions; ++r) {
+        auto start = Clock::now();
+        body(iterations);
+        double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+        samples.push_back(seconds * 1e9 / iterations);
+    }
+    std::sort(samples.begin(), samples.end());
+    return Result{name, iterations, samples[samples.size() / 2], samples.front(), samples.back()};
+}
+
+// Rebuilds a board cell by cell from occupancy rows and colors
+Board makeBoard(const std::vector<Board::Row>& rows, const std::vector<std::uint8_t>& colors) {
+    Board board;
+    for (int y = 0; y < Board::HEIGHT; ++y) {
+        for (int x = 0; x < Board::WIDTH; ++x) {
+            if ((rows[y] >> x) & 1u) {
+                board.place(Board::PieceRows{1, 0, 0, 0}, x, y, colors[y * Board::WIDTH + x]);
+            }
+        }
+    }
+    return board;
+}
+
+// Boards from seeded greedy and random games, sampled every few pieces, so the
+// corpus holds realistic stacks of every height
+std::vector<Board> makeCorpus(std::size_t count) {
+    std::vector<Board> corpus;
+    std::uint64_t seed = 1;
+    while (corpus.size() < count) {
+        Simulation simulation(seed);
+        std::unique_ptr<PlacementPolicy> policy = makePolicy(seed % 2 ? "greedy" : "random", seed);
+        Placement placement;
+        while (!simulation.isGameOver() && corpus.size() < count && simulation.getPieceCount() < 400) {
+            if (!policy->choose(simulation, placement) || simulation.place(placement) < 0) {
+                break;
+            }
+            if (simulation.getPieceCount() % 7 == 0 && simulation.getLives() == Simulation::START_LIVES) {
+                corpus.push_back(simulation.getBoard());
+            }
+        }
+        seed++;
+    }
+    return corpus;
+}
+
+// Copies of the corpus whose bottom `lines` rows are completely filled
+std::vector<Board> withFullRows(const std::vector<Board>& corpus, int lines) {
+    std::vector<Board> boards;
+    for (const Board& source : corpus) {
+        std::vector<Board::Row> rows(Board::HEIGHT);
+        std::vector<std::uint8_t> colors(Board::WIDTH * Board::HEIGHT);
+        for (int y = 0; y < Board::HEIGHT; ++y) {
+            rows[y] = source.getRow(y);
+            std::copy_n(source.getRowColors(y), Board::WIDTH, colors.begin() + y * Board::WIDTH);
+        }
+        for (int y = Board::HEIGHT - lines; y < Board::HEIGHT; ++y) {
+            rows[y] = (1u << Board::WIDTH) - 1;
+            for (int x = 0; x < Board::WIDTH; ++x) {
+                std::uint8_t& color = colors[y * Board::WIDTH + x];
+                color = color ? color : 1;
+            }
+        }
+        boards.push_back(makeBoard(rows, colors));
+    }
+    return boards;
+}
+
+// Drops each piece straight down and locks it, which clears lines and spawns
+// the next one; a new game starts after game over
+template <class Game>
+void lockAndSpawn(long long iterations) {
+    Game simulation(13);
+    std::uint64_t lines = 0;
+    for (long long i = 0; i < iterations; ++i) {
+        while (simulation.move(0, 1)) {
+        }
+        lines += simulation.lock();
+        if (simulation.isGameOver()) {
+            simulation.reset(13 + i);
+        }
+    }
+    gSink = gSink + lines;
+}
+
+void printJson(std::ostream& out, const std::vector<Result>& results, std::size_t corpusSize) {
+    std::time_t now = std::time(nullptr);
+    char date[32];
+    std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%SZ", std::gmtime(&now));
+
+    out << "{\n  \"context\": {\n"
+        << "    \"date\": \"" << date << "\",\n"
+#if defined(__clang__)
+        << "    \"compiler\": \"clang " << __clang_version__ << "\",\n"
+#elif defined(__GNUC__)
+        << "    \"compiler\": \"gcc " << __VERSION__ << "\",\n"
+#elif defined(_MSC_VER)
+        << "    \"compiler\": \"msvc " << _MSC_VER << "\",\n"
+#endif
+#ifdef NDEBUG
+        << "    \"optimized\": true,\n"
+#else
+        << "    \"optimized\": false,\n"
+#endif
+        << "    \"corpus_boards\": " << corpusSize << "\n  },\n  \"benchmarks\": [\n";
+    for (std::size_t i = 0; i < results.size(); ++i) {
+        const Result& r = results[i];
+        out << "    {\"name\": \"" << r.name << "\", \"iterations\": " << r.iterations
+            << ", \"ns_per_op\": " << r.nsPerOp << ", \"min_ns_per_op\": " << r.minNsPerOp
+            << ", \"max_ns_per_op\": " << r.maxNsPerOp << "}" << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    out << "  ]\n}" << std::endl;
+}
+
+bool parseOptions(int argc, char* argv[], Options& options) {
+    for (int i = 1; i < argc; ++i) {
+        const char* arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (std::strcmp(arg, "--filter") == 0 && hasValue) {
+            options.filter = argv[++i];
+        } else if (std::strcmp(arg, "--out") == 0 && hasValue) {
+            options.outputPath = argv[++i];
+        } else if (std::strcmp(arg, "--min-time") == 0 && hasValue) {
+            options.minTime = std::atof(argv[++i]);
+        } else if (std::strcmp(arg, "--repetitions") == 0 && hasValue) {
+            options.repetitions = std::max(1, std::atoi(argv[++i]));
+        } else if (std::strcmp(arg, "--check-allocations") == 0) {
+            options.checkAllocations = true;
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Plays games through both the input path and the placement path, with the
+// profiler recording, and counts heap allocations once everything is set up.
+// Returns the process exit status.
+int checkAllocations() {
+    const int TICKS = 1000000;
+    const int PLACEMENTS = 20000;
+
+    Simulation simulation(1);
+    GreedyPolicy greedy;
+    Random random(99);
+    Profiler::instance().setEnabled(true); // Allocates its ring buffer here
+
+    long long before = gAllocations.load();
+    std::uint64_t seed = 1;
+    for (int tick = 0; tick < TICKS; ++tick) {
+        Simulation::Input input = static_cast<Simulation::Input>(random.nextInt(5));
+        simulation.step(input, 1.0f / 60.0f);
+        if (simulation.isGameOver()) {
+            simulation.reset(++seed);
+        }
+    }
+    Placement placement;
+    for (int i = 0; i < PLACEMENTS; ++i) {
+        if (!greedy.choose(simulation, placement) || simulation.place(placement) < 0 || simulation.isGameOver()) {
+            simulation.reset(++seed);
+        }
+    }
+    long long allocations = gAllocations.load() - before;
+    Profiler::instance().setEnabled(false);
+
+    std::cout << "Heap allocations over " << TICKS << " ticks, " << PLACEMENTS << " placements and "
+              << seed << " games: " << allocations << std::endl;
+    return allocations == 0 ? 0 : 1;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        std::cerr << "Usage: " << argv[0]
+                  << " [--filter TEXT] [--out FILE] [--min-time SECONDS] [--repetitions N] [--check-allocations]\n";
+        return 1;
+    }
+    if (options.checkAllocations) {
+        return checkAllocations();
+    }
+
+    const std::vector<Board> corpus = makeCorpus(256);
+    const std::size_t corpusMask = corpus.size() - 1; // Power of two
+
+    // Random piece poses near the stacks, shared by the collision benchmarks
+    struct Probe {
+        int type;
+        int rotation;
+        int x;
+        int y;
+    };
+    std::vector<Probe> probes(4096);
+    Random random(42);
+    for (Probe& probe : probes) {
+        probe = Probe{random.nextInt(7), random.nextInt(4), random.nextInt(Board::WIDTH + 3) - 3,
+                      random.nextInt(Board::HEIGHT + 2) - 2};
+    }
+
+    std::vector<std::pair<std::string, Body>> benchmarks;
+
+    benchmarks.emplace_back("collision", [&](long long iterations) {
+        std::uint64_t hits = 0;
+        for (long long i = 0; i < iterations; ++i) {
+            const Probe& p = probes[i & (probes.size() - 1)];
+            const Board& board = corpus[(i >> 12) & corpusMask];
+            hits += board.collides(Tetromino::SHAPES[p.type][p.rotation].rows, p.x, p.y);
+        }
+        gSink = gSink + hits;
+    });
+
+    benchmarks.emplace_back("drop_distance", [&](long long iterations) {
+        // Landing row of a piece dropped from the top, as for the ghost piece
+        std::uint64_t rows = 0;
+        for (long long i = 0; i < iterations; ++i) {
+            const Probe& p = probes[i & (probes.size() - 1)];
+            const Board& board = corpus[(i >> 12) & corpusMask];
+            const Orientation& orientation = Tetromino::SHAPES[p.type][p.rotation];
+            if (!board.collides(orientation.rows, p.x, 0)) {
+                rows += board.dropDistance(orientation.rows, orientation.bottoms, p.x, 0);
+            }
+        }
+        gSink = gSink + rows;
+    });
+
+    for (int lines = 0; lines <= 4; ++lines) {
+        auto boards = std::make_shared<std::vector<Board>>(withFullRows(corpus, lines));
+        benchmarks.emplace_back("clear_lines_" + std::to_string(lines), [boards, corpusMask](long long iterations) {
+            std::uint64_t cleared = 0;
+            for (long long i = 0; i < iterations; ++i) {
+                Board board = (*boards)[i & corpusMask]; // The copy is part of the measured cost
+                cleared += board.clearFullLines();
+            }
+            gSink = gSink + cleared;
+        });
+    }
+
+    benchmarks.emplace_back("rotate_with_kicks", [&](long long iterations) {
+        // Clockwise rotation through the orientation and kick tables
+        std::uint64_t rotated = 0;
+        Simulation simulation(7);
+        for (long long i = 0; i < iterations; ++i) {
+            rotated += simulation.rotate();
+        }
+        gSink = gSink + rotated;
+    });
+
+    benchmarks.emplace_back("spawn", [&](long long iterations) {
+        Simulation simulation(11);
+        for (long long i = 0; i < iterations; ++i) {
+            simulation.spawnTetromino();
+        }
+        gSink = gSink + simulation.getPieceCount();
+    });
+
+    benchmarks.emplace_back("undo_push_pop", [&](long long iterations) {
+        // Saving and restoring a whole game, as a search branches and rewinds
+        UndoStack<Simulation> undo(64);
+        Simulation simulation(19);
+        for (long long i = 0; i < iterations; ++i) {
+            undo.push(simulation);
+            undo.pop(simulation);
+        }
+        gSink = gSink + simulation.getScore();
+    });
+
+    benchmarks.emplace_back("state_save_load", [&](long long iterations) {
+        Simulation simulation(19);
+        std::vector<std::uint8_t> bytes;
+        std::uint64_t loaded = 0;
+        for (long long i = 0; i < iterations; ++i) {
+            bytes.clear(); // Keeps its capacity
+            simulation.saveState(bytes);
+            loaded += simulation.loadState(bytes.data(), bytes.size());
+        }
+        gSink = gSink + loaded;
+    });
+
+    benchmarks.emplace_back("lock_and_spawn", lockAndSpawn<Simulation>);
+    benchmarks.emplace_back("lock_and_spawn_wide", lockAndSpawn<WideSimulation>);
+    benchmarks.emplace_back("lock_and_spawn_tall", lockAndSpawn<TallSimulation>);
+
+    // Gravity on many games at once, one Simulation object per game versus a
+    // BoardBatch; both report the cost of one game advancing one step
+    const std::size_t GAMES = 1024;
+    benchmarks.emplace_back("simulation_gravity_step", [&](long long iterations) {
+        std::vector<Simulation> games;
+        for (std::size_t i = 0; i < GAMES; ++i) {
+            games.emplace_back(100 + i);
+        }
+        long long steps = 0;
+        while (steps < iterations) {
+            for (Simulation& game : games) {
+                game.step(Simulation::Input::None, 1.0f);
+                if (game.isGameOver()) {
+                    game.reset(game.getSeed() + GAMES);
+                }
+            }
+            steps += GAMES;
+        }
+        gSink = gSink + games[0].getScore();
+    });
+
+    benchmarks.emplace_back("batch_gravity_step", [&](long long iterations) {
+        BoardBatch batch(GAMES);
+        batch.resetAll(100);
+        long long steps = 0;
+        while (steps < iterations) {
+            if (batch.stepGravity() < GAMES) {
+                for (std::size_t i = 0; i < GAMES; ++i) {
+                    if (batch.isGameOver(i)) {
+                        batch.reset(i, steps + i);
+                    }
+                }
+            }
+            steps += GAMES;
+        }
+        gSink = gSink + batch.getScore(0);
+    });
+
+    benchmarks.emplace_back("placement_search", [&](long long iterations) {
+        PlacementSearch search;
+        std::uint64_t placements = 0;
+        for (long long i = 0; i < iterations; ++i) {
+            Tetromino piece(static_cast<int>(i % 7), Simulation::SPAWN_X, 0);
+            placements += search.search(corpus[(i >> 3) & corpusMask], piece);
+        }
+        gSink = gSink + placements;
+    });
+
+    benchmarks.emplace_back("greedy_choice", [&](long long iterations) {
+        GreedyPolicy policy;
+        Simulation simulation(17);
+        Placement placement;
+        for (long long i = 0; i < iterations; ++i) {
+            policy.choose(simulation, placement);
+            gSink = gSink + placement.x;
+        }
+    });
+
+    benchmarks.emplace_back("lookahead_depth2", [&](long long iterations) {
+        // The falling and next pieces, every reachable placement of both
+        LookaheadSearch search(0, 12);
+        Simulation simulation(17);
+        Placement placement;
+        for (long long i = 0; i < iterations; ++i) {
+            search.findBest(simulation, placement, 0.0, 2);
+            gSink = gSink + placement.x;
+        }
+    });
+
+    std::vector<Result> results;
+    for (const auto& benchmark : benchmarks) {
+        if (benchmark.first.find(options.filter) == std::string::npos) {
+            continue;
+        }
+        results.push_back(runBenchmark(benchmark.first, benchmark.second, options));
+        std::cerr << benchmark.first << ": " << results.back().nsPerOp << " ns/op" << std::endl;
+    }
+
+    if (options.outputPath.empty()) {
+        printJson(std::cout, results, corpus.size());
+    } else {
+        std::ofstream out(options.outputPath);
+        if (!out.is_open()) {
+            std::cerr << "Unable to open " << options.outputPath << " for writing." << std::endl;
+            return 1;
+        }
+        printJson(out, results, corpus.size());
+    }
+    return 0;
+}
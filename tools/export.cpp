@@ -0,0 +1,161 @@
+// Exports one training row per locked piece, from headless self-play games
+// or from recorded replays, to a columnar training data file.
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+#include "MappedFile.h"
+#include "Policy.h"
+#include "Replay.h"
+#include "Simulation.h"
+#include "TrainingData.h"
+#include "WorkStealingPool.h"
+
+namespace {
+
+struct Options {
+    std::string outPath;
+    int games = 1000;
+    unsigned threads = std::thread::hardware_concurrency();
+    std::string policy = "greedy";
+    int maxPieces = 1000;
+    std::uint64_t seed = 1; // Game i is played with seed + i
+    std::vector<std::string> replays; // Exported instead of self-play when given
+};
+
+void printUsage(const char* program) {
+    std::cerr << "Usage: " << program << " --out FILE [options] [REPLAY...]\n"
+              << "  --out FILE       Training data file to write\n"
+              << "  --threads N      Worker threads (default: all cores)\n"
+              << "Without replays, plays new games:\n"
+              << "  --games N        Games to play (default 1000)\n"
+              << "  --policy NAME    random, greedy or lookahead (default greedy)\n"
+              << "  --max-pieces N   Stop a game after N pieces (default 1000)\n"
+              << "  --seed N         Seed of the first game (default 1)\n";
+}
+
+bool parseOptions(int argc, char* argv[], Options& options) {
+    for (int i = 1; i < argc; ++i) {
+        const char* arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (std::strcmp(arg, "--out") == 0 && hasValue) {
+            options.outPath = argv[++i];
+        } else if (std::strcmp(arg, "--games") == 0 && hasValue) {
+            options.games = std::atoi(argv[++i]);
+        } else if (std::strcmp(arg, "--threads") == 0 && hasValue) {
+            options.threads = static_cast<unsigned>(std::atoi(argv[++i]));
+        } else if (std::strcmp(arg, "--policy") == 0 && hasValue) {
+            options.policy = argv[++i];
+        } else if (std::strcmp(arg, "--max-pieces") == 0 && hasValue) {
+            options.maxPieces = std::atoi(argv[++i]);
+        } else if (std::strcmp(arg, "--seed") == 0 && hasValue) {
+            options.seed = std::strtoull(argv[++i], nullptr, 10);
+        } else if (arg[0] == '-') {
+            return false;
+        } else {
+            options.replays.push_back(arg);
+        }
+    }
+    return !options.outPath.empty() && options.games > 0 && options.maxPieces > 0;
+}
+
+// Rows are gathered per game and appended as one batch, so workers only
+// contend for the writer once per game
+bool exportGame(TrainingDataWriter& writer, PlacementPolicy& policy, std::uint64_t seed, int maxPieces) {
+    Simulation simulation(seed);
+    std::vector<TrainingRecord> records;
+    Placement placement;
+    while (!simulation.isGameOver() && simulation.getPieceCount() <= maxPieces) { // Counts the falling piece
+        if (!policy.choose(simulation, placement)) {
+            break; // Nowhere left to put the piece
+        }
+        Board before = simulation.getBoard();
+        if (simulation.place(placement) < 0) {
+            break;
+        }
+        records.push_back(TrainingRecord::make(before, simulation.getLastLock()));
+    }
+    return writer.append(records.data(), records.size(), seed);
+}
+
+bool exportReplay(TrainingDataWriter& writer, const std::string& path) {
+    MappedFile file;
+    ReplayPlayer player;
+    if (!file.open(path) || !player.open(file.getData(), file.getSize())) {
+        std::cerr << path << ": not a readable replay" << std::endl;
+        return false;
+    }
+
+    Simulation simulation;
+    player.start(simulation);
+    std::vector<TrainingRecord> records;
+    Board before = simulation.getBoard();
+    int pieceCount = simulation.getPieceCount();
+    auto afterStep = [&] {
+        if (simulation.getPieceCount() != pieceCount) { // A piece locked
+            records.push_back(TrainingRecord::make(before, simulation.getLastLock()));
+            before = simulation.getBoard();
+            pieceCount = simulation.getPieceCount();
+        }
+    };
+    while (player.tick(simulation, afterStep)) {
+    }
+    return writer.append(records.data(), records.size(), player.getHeader().seed);
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    Options options;
+    if (!parseOptions(argc, argv, options) || !makePolicy(options.policy, 0)) {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    TrainingDataWriter writer;
+    if (!writer.open(options.outPath)) {
+        std::cerr << "Unable to write " << options.outPath << std::endl;
+        return 1;
+    }
+
+    std::atomic<int> failures(0);
+    auto start = std::chrono::steady_clock::now();
+    {
+        WorkStealingPool pool(options.threads);
+        if (options.replays.empty()) {
+            for (int i = 0; i < options.games; ++i) {
+                pool.submit([&writer, &options, &failures, i] {
+                    std::uint64_t seed = options.seed + i;
+                    std::unique_ptr<PlacementPolicy> policy = makePolicy(options.policy, seed);
+                    if (!exportGame(writer, *policy, seed, options.maxPieces)) {
+                        failures++;
+                    }
+                });
+            }
+        } else {
+            for (const std::string& path : options.replays) {
+                pool.submit([&writer, &failures, &path] {
+                    if (!exportReplay(writer, path)) {
+                        failures++;
+                    }
+                });
+            }
+        }
+        pool.wait();
+    }
+    if (!writer.close()) {
+        std::cerr << "Unable to write " << options.outPath << std::endl;
+        return 1;
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::cout << writer.getRowCount() << " rows from " << writer.getGameCount() << " games in " << seconds
+              << " s (" << writer.getRowCount() / seconds << " rows/s) to " << options.outPath << std::endl;
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,97 @@
+// Re-simulates recorded games headlessly at full speed, in parallel, and
+// prints each game's final score.
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "MappedFile.h"
+#include "Replay.h"
+#include "Simulation.h"
+#include "WorkStealingPool.h"
+
+namespace {
+
+struct ReplayResult {
+    bool valid = false;
+    int score = 0;
+    int level = 0;
+    int lines = 0;
+    int pieces = 0;
+    std::uint32_t ticks = 0;
+};
+
+ReplayResult playReplay(const std::string& path) {
+    ReplayResult result;
+    MappedFile file;
+    ReplayPlayer player;
+    if (!file.open(path) || !player.open(file.getData(), file.getSize())) {
+        return result;
+    }
+
+    Simulation simulation;
+    player.start(simulation);
+    while (player.tick(simulation)) {
+    }
+
+    result.valid = true;
+    result.score = simulation.getScore();
+    result.level = simulation.getLevel();
+    result.lines = simulation.getLinesCleared();
+    result.pieces = simulation.getPieceCount();
+    result.ticks = player.getTick();
+    return result;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    unsigned threads = std::thread::hardware_concurrency();
+    std::vector<std::string> paths;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            threads = static_cast<unsigned>(std::atoi(argv[++i]));
+        } else if (argv[i][0] == '-') {
+            paths.clear();
+            break;
+        } else {
+            paths.push_back(argv[i]);
+        }
+    }
+    if (paths.empty()) {
+        std::cerr << "Usage: " << argv[0] << " [--threads N] FILE...\n";
+        return 1;
+    }
+
+    std::vector<ReplayResult> results(paths.size());
+    auto start = std::chrono::steady_clock::now();
+    {
+        WorkStealingPool pool(threads);
+        for (std::size_t i = 0; i < paths.size(); ++i) {
+            pool.submit([&results, &paths, i] { results[i] = playReplay(paths[i]); });
+        }
+        pool.wait();
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    int failures = 0;
+    long long totalTicks = 0;
+    for (std::size_t i = 0; i < paths.size(); ++i) {
+        const ReplayResult& result = results[i];
+        if (!result.valid) {
+            std::cerr << paths[i] << ": not a readable replay" << std::endl;
+            failures++;
+            continue;
+        }
+        totalTicks += result.ticks;
+        std::cout << paths[i] << ": score " << result.score << ", level " << result.level
+                  << ", lines " << result.lines << ", pieces " << result.pieces
+                  << ", ticks " << result.ticks << "\n";
+    }
+    std::cout << paths.size() - failures << " replays in " << seconds << " s ("
+              << (paths.size() - failures) / seconds << " replays/s, "
+              << totalTicks / seconds << " ticks/s)" << std::endl;
+    return failures == 0 ? 0 : 1;
+}
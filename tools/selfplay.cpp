@@ -0,0 +1,200 @@
+// Plays many independent headless games in parallel with a placement policy
+// and reports throughput, lines per game and the score distribution.
+
+#include <algorithm>
+#include <bitset>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "Policy.h"
+#include "Profiler.h"
+#include "Simulation.h"
+#include "WorkStealingPool.h"
+
+namespace {
+
+struct Options {
+    int games = 1000;
+    unsigned threads = std::thread::hardware_concurrency();
+    std::string policy = "greedy";
+    int maxPieces = 1000; // Caps games a strong policy would never lose
+    std::uint64_t seed = 1; // Game i is played with seed + i
+    std::string tracePath;  // Chrome trace of the run, when set
+};
+
+struct GameResult {
+    int score = 0;
+    int lines = 0;
+    int pieces = 0;
+    int badLocks = 0; // Locks that did not add exactly the piece's cells
+};
+
+void printUsage(const char* program) {
+    std::cerr << "Usage: " << program << " [options]\n"
+              << "  --games N        Games to play (default 1000)\n"
+              << "  --threads N      Worker threads (default: all cores)\n"
+              << "  --policy NAME    random, greedy or lookahead (default greedy)\n"
+              << "  --max-pieces N   Stop a game after N pieces (default 1000)\n"
+              << "  --seed N         Seed of the first game (default 1)\n"
+              << "  --trace FILE     Profile the run and write a Chrome trace\n";
+}
+
+bool parseOptions(int argc, char* argv[], Options& options) {
+    for (int i = 1; i < argc; ++i) {
+        const char* arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (std::strcmp(arg, "--games") == 0 && hasValue) {
+            options.games = std::atoi(argv[++i]);
+        } else if (std::strcmp(arg, "--threads") == 0 && hasValue) {
+            options.threads = static_cast<unsigned>(std::atoi(argv[++i]));
+        } else if (std::strcmp(arg, "--policy") == 0 && hasValue) {
+            options.policy = argv[++i];
+        } else if (std::strcmp(arg, "--max-pieces") == 0 && hasValue) {
+            options.maxPieces = std::atoi(argv[++i]);
+        } else if (std::strcmp(arg, "--seed") == 0 && hasValue) {
+            options.seed = std::strtoull(argv[++i], nullptr, 10);
+        } else if (std::strcmp(arg, "--trace") == 0 && hasValue) {
+            options.tracePath = argv[++i];
+        } else {
+            return false;
+        }
+    }
+    return options.games > 0 && options.maxPieces > 0;
+}
+
+int countCells(const Board& board) {
+    int cells = 0;
+    for (int y = 0; y < Board::HEIGHT; ++y) {
+        cells += static_cast<int>(std::bitset<Board::WIDTH>(board.getRow(y)).count());
+    }
+    return cells;
+}
+
+GameResult playGame(PlacementPolicy& policy, std::uint64_t seed, int maxPieces) {
+    ProfileScope probe("playGame");
+    Simulation simulation(seed);
+    Placement placement;
+    GameResult result;
+    while (!simulation.isGameOver() && simulation.getPieceCount() <= maxPieces) { // Counts the falling piece
+        int cellsBefore = countCells(simulation.getBoard());
+        if (!policy.choose(simulation, placement) || simulation.place(placement) < 0) {
+            break; // Nowhere left to put the piece
+        }
+        // Every lock keeps all four cells, less the lines it clears, unless
+        // it cost a life and the board was cleared
+        const LockResult& lock = simulation.getLastLock();
+        if (!lock.lostLife && countCells(simulation.getBoard()) != cellsBefore + 4 - Board::WIDTH * lock.linesCleared) {
+            result.badLocks++;
+        }
+    }
+
+    result.score = simulation.getScore();
+    result.lines = simulation.getLinesCleared();
+    result.pieces = simulation.getPieceCount() - 1; // Placed pieces only
+    return result;
+}
+
+// The I piece must turn about the SRS center that its kick table assumes:
+// resting on the floor it can still rotate, and two turns at the spawn point
+// move its cells down exactly one row
+bool checkIRotation() {
+    std::uint64_t seed = 0;
+    while (Simulation(seed).getCurrentTetromino().getType() != 1) {
+        seed++;
+    }
+
+    Simulation floor(seed);
+    while (floor.move(0, 1)) {
+    }
+    if (!floor.rotate()) {
+        return false;
+    }
+
+    Simulation spin(seed);
+    const Tetromino& piece = spin.getCurrentTetromino();
+    int top = piece.getPosition().y + piece.getOrientation().min.y;
+    if (!spin.rotate() || !spin.rotate()) {
+        return false;
+    }
+    return piece.getPosition().y + piece.getOrientation().min.y == top + 1;
+}
+
+int percentile(const std::vector<int>& sorted, double p) {
+    std::size_t index = static_cast<std::size_t>(p * (sorted.size() - 1) + 0.5);
+    return sorted[index];
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    Options options;
+    if (!parseOptions(argc, argv, options) || !makePolicy(options.policy, 0)) {
+        printUsage(argv[0]);
+        return 1;
+    }
+    if (!checkIRotation()) {
+        std::cerr << "The I piece does not rotate about its SRS center" << std::endl;
+        return 1;
+    }
+
+    std::vector<GameResult> results(options.games);
+    Profiler::instance().setEnabled(!options.tracePath.empty());
+    auto start = std::chrono::steady_clock::now();
+    {
+        WorkStealingPool pool(options.threads);
+        for (int i = 0; i < options.games; ++i) {
+            pool.submit([&results, &options, i] {
+                std::uint64_t seed = options.seed + i;
+                std::unique_ptr<PlacementPolicy> policy = makePolicy(options.policy, seed);
+                results[i] = playGame(*policy, seed, options.maxPieces);
+            });
+        }
+        pool.wait();
+        options.threads = pool.getThreadCount();
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::vector<int> scores;
+    long long totalLines = 0;
+    long long totalPieces = 0;
+    long long badLocks = 0;
+    for (const GameResult& result : results) {
+        badLocks += result.badLocks;
+        scores.push_back(result.score);
+        totalLines += result.lines;
+        totalPieces += result.pieces;
+    }
+    std::sort(scores.begin(), scores.end());
+    double meanScore = 0.0;
+    for (int score : scores) {
+        meanScore += score;
+    }
+    meanScore /= scores.size();
+
+    std::cout << "Policy:          " << options.policy << " on " << options.threads << " threads\n"
+              << "Games:           " << options.games << " in " << seconds << " s ("
+              << options.games / seconds << " games/s, " << totalPieces / seconds << " pieces/s)\n"
+              << "Lines per game:  " << static_cast<double>(totalLines) / options.games << "\n"
+              << "Pieces per game: " << static_cast<double>(totalPieces) / options.games << "\n"
+              << "Score:           mean " << meanScore
+              << ", min " << scores.front()
+              << ", p10 " << percentile(scores, 0.10)
+              << ", p50 " << percentile(scores, 0.50)
+              << ", p90 " << percentile(scores, 0.90)
+              << ", p99 " << percentile(scores, 0.99)
+              << ", max " << scores.back() << std::endl;
+
+    if (badLocks > 0) {
+        std::cerr << badLocks << " locks lost or added cells" << std::endl;
+        return 1;
+    }
+    if (!options.tracePath.empty() && !Profiler::instance().writeChromeTrace(options.tracePath)) {
+        std::cerr << "Unable to write trace to " << options.tracePath << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,131 @@
+// A stand-in spectator: connects to a game's spectator server, rebuilds the
+// game from the keyframes and deltas, and prints the mirrored state once a
+// second. Checkpoint keyframes are compared with the state the deltas built,
+// so a run also checks the stream end to end.
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include "Spectator.h"
+
+namespace {
+
+int connectTcp(std::uint16_t port) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(port);
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (fd >= 0 && connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+int connectUnix(const std::string& path) {
+    sockaddr_un address = {};
+    if (path.size() >= sizeof(address.sun_path)) {
+        return -1;
+    }
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    address.sun_family = AF_UNIX;
+    std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+    if (fd >= 0 && connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+void printState(const SpectatorDecoder& decoder, long long bytes) {
+    const SpectatorSnapshot& state = decoder.getSnapshot();
+    std::cout << "tick " << state.tick << ": score " << state.score << ", level " << state.level << ", lines "
+              << state.linesCleared << ", lives " << state.lives << (state.gameOver ? ", game over" : "") << " | "
+              << decoder.getKeyframes() << " keyframes, " << decoder.getDeltas() << " deltas, " << bytes
+              << " bytes, " << decoder.getMismatches() << " mismatches" << std::endl;
+}
+
+void printBoard(const SpectatorSnapshot& state) {
+    for (int y = 0; y < SpectatorSnapshot::HEIGHT; ++y) {
+        std::string row = "|";
+        for (int x = 0; x < SpectatorSnapshot::WIDTH; ++x) {
+            std::uint8_t cell = state.cells[y * SpectatorSnapshot::WIDTH + x];
+            row += cell ? static_cast<char>('0' + cell) : '.';
+        }
+        std::cout << row << "|\n";
+    }
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    int port = -1;
+    std::string socketPath;
+    bool showBoard = false;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--port") == 0 && i + 1 < argc) {
+            port = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--socket") == 0 && i + 1 < argc) {
+            socketPath = argv[++i];
+        } else if (std::strcmp(argv[i], "--board") == 0) {
+            showBoard = true;
+        } else {
+            port = -1;
+            socketPath.clear();
+            break;
+        }
+    }
+    if ((port < 0) == socketPath.empty()) {
+        std::cerr << "Usage: " << argv[0] << " (--port N | --socket PATH) [--board]\n"
+                  << "  --port N        Connect to the spectator server on 127.0.0.1:N\n"
+                  << "  --socket PATH   Connect to the spectator server's Unix socket\n"
+                  << "  --board         Also print the mirrored board with each update\n";
+        return 1;
+    }
+
+    int fd = socketPath.empty() ? connectTcp(static_cast<std::uint16_t>(port)) : connectUnix(socketPath);
+    if (fd < 0) {
+        std::cerr << "Unable to connect: " << std::strerror(errno) << std::endl;
+        return 1;
+    }
+
+    SpectatorDecoder decoder;
+    std::uint8_t buffer[4096];
+    long long bytes = 0;
+    auto lastPrint = std::chrono::steady_clock::now();
+    for (;;) {
+        ssize_t received = recv(fd, buffer, sizeof(buffer), 0);
+        if (received <= 0) {
+            break; // The game closed the stream
+        }
+        bytes += received;
+        if (!decoder.feed(buffer, static_cast<std::size_t>(received))) {
+            std::cerr << "Malformed spectator stream" << std::endl;
+            close(fd);
+            return 1;
+        }
+
+        auto now = std::chrono::steady_clock::now();
+        if (decoder.hasSnapshot() && now - lastPrint >= std::chrono::seconds(1)) {
+            lastPrint = now;
+            printState(decoder, bytes);
+            if (showBoard) {
+                printBoard(decoder.getSnapshot());
+            }
+        }
+    }
+    close(fd);
+
+    if (decoder.hasSnapshot()) {
+        printState(decoder, bytes);
+    }
+    return decoder.getMismatches() == 0 ? 0 : 1;
+}
@@ -0,0 +1,393 @@
+// Plays Tetris in a POSIX terminal. Every frame is drawn into a TerminalScreen,
+// which writes only the cells that changed as ANSI escape sequences, so the
+// game runs over SSH and serial consoles without a window system.
+
+#include <poll.h>
+#include <signal.h>
+#include <termios.h>
+#include <unistd.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include "Simulation.h"
+#include "SpectatorServer.h"
+#include "TerminalScreen.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+volatile sig_atomic_t gQuit = 0;
+volatile sig_atomic_t gResized = 0;
+
+void onQuitSignal(int) {
+    gQuit = 1;
+}
+
+void onResize(int) {
+    gResized = 1;
+}
+
+// Raw, unechoed keyboard input and the alternate screen for as long as it
+// lives; the terminal is restored however the game ends
+class TerminalSession {
+public:
+    TerminalSession() : mActive(tcgetattr(STDIN_FILENO, &mSaved) == 0) {
+        if (mActive) {
+            termios raw = mSaved;
+            raw.c_lflag &= static_cast<tcflag_t>(~(ICANON | ECHO)); // Keep ISIG, so Ctrl-C still quits
+            raw.c_cc[VMIN] = 0;
+            raw.c_cc[VTIME] = 0;
+            tcsetattr(STDIN_FILENO, TCSAFLUSH, &raw);
+        }
+        write("\x1b[?1049h\x1b[?25l"); // Alternate screen, hidden cursor
+    }
+
+    ~TerminalSession() {
+        write("\x1b[0m\x1b[?25h\x1b[?1049l");
+        if (mActive) {
+            tcsetattr(STDIN_FILENO, TCSAFLUSH, &mSaved);
+        }
+    }
+
+    TerminalSession(const TerminalSession&) = delete;
+    TerminalSession& operator=(const TerminalSession&) = delete;
+
+    bool isTerminal() const { return mActive; }
+
+    // Writes the whole string, retrying short writes
+    static bool write(const std::string& data) {
+        std::size_t written = 0;
+        while (written < data.size()) {
+            ssize_t result = ::write(STDOUT_FILENO, data.data() + written, data.size() - written);
+            if (result < 0) {
+                return false;
+            }
+            written += static_cast<std::size_t>(result);
+        }
+        return true;
+    }
+
+private:
+    bool mActive;
+    termios mSaved;
+};
+
+enum class Key { None, Left, Right, Up, Down, Space, Restart, Quit };
+
+// A lone Esc and the start of an escape sequence begin with the same byte.
+// The rest of a sequence arrives within this time, or never.
+constexpr auto ESCAPE_TIMEOUT = std::chrono::milliseconds(50);
+
+// Decodes one key from the bytes read so far. Returns the bytes used, or 0 if
+// the buffer ends inside an escape sequence. Once the escape timeout has
+// passed (timedOut), a pending ESC is taken as an Esc press, which maps to no
+// key, and only that byte is used.
+std::size_t decodeKey(const char* data, std::size_t size, bool timedOut, Key& key) {
+    key = Key::None;
+    if (data[0] == '\x1b') {
+        if (size < 3) {
+            return timedOut ? 1 : 0; // Possibly a sequence split across reads
+        }
+        if (data[1] == '[' || data[1] == 'O') {
+            switch (data[2]) {
+                case 'A': key = Key::Up;    break;
+                case 'B': key = Key::Down;  break;
+                case 'C': key = Key::Right; break;
+                case 'D': key = Key::Left;  break;
+                default: break;
+            }
+            return 3;
+        }
+        return 1;
+    }
+    switch (data[0]) {
+        case ' ':           key = Key::Space;   break;
+        case 'h': case 'a': key = Key::Left;    break;
+        case 'l': case 'd': key = Key::Right;   break;
+        case 'k': case 'w': key = Key::Up;      break;
+        case 'j': case 's': key = Key::Down;    break;
+        case 'r':           key = Key::Restart; break;
+        case 'q':           key = Key::Quit;    break;
+        default: break;
+    }
+    return 1;
+}
+
+struct Style {
+    bool color = true; // 256-color blocks; otherwise plain characters for mono consoles
+};
+
+// Board cells are two columns wide, so they come out roughly square
+constexpr int CELL_COLUMNS = 2;
+constexpr int BOARD_LEFT = 1; // After the left wall
+constexpr int HUD_LEFT = BOARD_LEFT + Simulation::BoardType::WIDTH * CELL_COLUMNS + 3;
+constexpr std::int16_t GRID_DOT_COLOR = 240;
+
+void drawBlock(TerminalScreen& screen, int x, int y, int type, const Style& style) {
+    if (style.color) {
+        std::int16_t color = TerminalScreen::toPaletteColor(Tetromino::COLORS[type]);
+        screen.put(x, y, ' ', TerminalScreen::DEFAULT_COLOR, color);
+        screen.put(x + 1, y, ' ', TerminalScreen::DEFAULT_COLOR, color);
+    } else {
+        screen.put(x, y, '[');
+        screen.put(x + 1, y, ']');
+    }
+}
+
+void drawPiece(TerminalScreen& screen, const Tetromino& piece, int left, int top, int dy, bool ghost, const Style& style) {
+    Cell position = piece.getPosition();
+    for (const Cell& block : piece.getShape()) {
+        int x = left + (position.x + block.x) * CELL_COLUMNS;
+        int y = top + position.y + block.y + dy;
+        if (position.y + block.y + dy < 0) {
+            continue; // Above the visible grid
+        }
+        if (ghost) {
+            std::int16_t color = style.color ? TerminalScreen::toPaletteColor(Tetromino::COLORS[piece.getType()])
+                                             : TerminalScreen::DEFAULT_COLOR;
+            screen.put(x, y, ':', color);
+            screen.put(x + 1, y, ':', color);
+        } else {
+            drawBlock(screen, x, y, piece.getType(), style);
+        }
+    }
+}
+
+void drawGame(TerminalScreen& screen, const Simulation& simulation, int bestScore, const Style& style) {
+    using BoardType = Simulation::BoardType;
+    const BoardType& board = simulation.getBoard();
+    screen.clear();
+
+    // Walls, floor and the settled cells
+    for (int y = 0; y < BoardType::HEIGHT; ++y) {
+        screen.put(0, y, '|');
+        screen.put(BOARD_LEFT + BoardType::WIDTH * CELL_COLUMNS, y, '|');
+        const std::uint8_t* colors = board.getRowColors(y);
+        for (int x = 0; x < BoardType::WIDTH; ++x) {
+            int column = BOARD_LEFT + x * CELL_COLUMNS;
+            if (colors[x] != 0) {
+                drawBlock(screen, column, y, colors[x] - 1, style);
+            } else {
+                screen.put(column + 1, y, '.', style.color ? GRID_DOT_COLOR : TerminalScreen::DEFAULT_COLOR);
+            }
+        }
+    }
+    screen.put(0, BoardType::HEIGHT, '+');
+    for (int x = 1; x <= BoardType::WIDTH * CELL_COLUMNS; ++x) {
+        screen.put(x, BoardType::HEIGHT, '-');
+    }
+    screen.put(BOARD_LEFT + BoardType::WIDTH * CELL_COLUMNS, BoardType::HEIGHT, '+');
+
+    if (!simulation.isGameOver()) {
+        const Tetromino& current = simulation.getCurrentTetromino();
+        drawPiece(screen, current, BOARD_LEFT, 0, simulation.getDropDistance(), true, style);
+        drawPiece(screen, current, BOARD_LEFT, 0, 0, false, style);
+    }
+
+    // HUD
+    char line[32];
+    std::snprintf(line, sizeof(line), "Score: %d", simulation.getScore());
+    screen.text(HUD_LEFT, 0, line);
+    std::snprintf(line, sizeof(line), "Level: %d", simulation.getLevel());
+    screen.text(HUD_LEFT, 1, line);
+    std::snprintf(line, sizeof(line), "Lines: %d", simulation.getLinesCleared());
+    screen.text(HUD_LEFT, 2, line);
+    std::snprintf(line, sizeof(line), "Lives: %d", simulation.getLives());
+    screen.text(HUD_LEFT, 3, line);
+    std::snprintf(line, sizeof(line), "Best:  %d", bestScore);
+    screen.text(HUD_LEFT, 4, line, style.color ? 226 : TerminalScreen::DEFAULT_COLOR);
+
+    screen.text(HUD_LEFT, 6, "NEXT:");
+    drawPiece(screen, simulation.getNextTetromino(), HUD_LEFT, 7, 0, false, style);
+
+    if (simulation.isGameOver()) {
+        screen.text(BOARD_LEFT + 5, BoardType::HEIGHT / 2, " GAME OVER ", style.color ? 196 : TerminalScreen::DEFAULT_COLOR);
+        screen.text(HUD_LEFT, 12, "r: new game");
+        screen.text(HUD_LEFT, 13, "q: quit");
+    } else {
+        screen.text(HUD_LEFT, 12, "Left/Right: move");
+        screen.text(HUD_LEFT, 13, "Up: rotate");
+        screen.text(HUD_LEFT, 14, "Down: soft drop");
+        screen.text(HUD_LEFT, 15, "Space: hard drop");
+        screen.text(HUD_LEFT, 16, "q: quit");
+    }
+}
+
+void printUsage(const char* program) {
+    std::cerr << "Usage: " << program << " [options]\n"
+              << "  --seed N        Seed of the first game (default: random)\n"
+              << "  --tick-rate N   Simulation ticks per second (default 60)\n"
+              << "  --mono          No colors, for consoles without 256-color support\n"
+              << "  --spectate-port N        Stream the game to spectators on 127.0.0.1:N\n"
+              << "  --spectate-socket PATH   Stream the game to spectators on a Unix socket\n";
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    std::uint64_t seed = SimulationBase::makeSeed();
+    unsigned tickRate = 60;
+    Style style;
+    SpectatorServer spectators;
+    for (int i = 1; i < argc; ++i) {
+        const char* arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (std::strcmp(arg, "--seed") == 0 && hasValue) {
+            seed = std::strtoull(argv[++i], nullptr, 10);
+        } else if (std::strcmp(arg, "--tick-rate") == 0 && hasValue) {
+            tickRate = static_cast<unsigned>(std::atoi(argv[++i]));
+        } else if (std::strcmp(arg, "--mono") == 0) {
+            style.color = false;
+        } else if (std::strcmp(arg, "--spectate-port") == 0 && hasValue) {
+            if (!spectators.listenTcp(static_cast<std::uint16_t>(std::atoi(argv[++i])))) {
+                return 1;
+            }
+        } else if (std::strcmp(arg, "--spectate-socket") == 0 && hasValue) {
+            if (!spectators.listenUnix(argv[++i])) {
+                return 1;
+            }
+        } else {
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+    if (tickRate == 0) {
+        std::cerr << "--tick-rate must be at least 1" << std::endl;
+        return 1;
+    }
+
+    struct sigaction action = {};
+    action.sa_handler = onQuitSignal;
+    sigaction(SIGINT, &action, nullptr);
+    sigaction(SIGTERM, &action, nullptr);
+    action.sa_handler = onResize;
+    sigaction(SIGWINCH, &action, nullptr);
+
+    const Clock::duration tickTime = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / tickRate));
+    const float tickSeconds = 1.0f / tickRate;
+
+    Simulation simulation(seed);
+    TerminalScreen screen(HUD_LEFT + 20, Simulation::BoardType::HEIGHT + 1);
+    std::string frame;
+    frame.reserve(16 * 1024);
+    char input[64];
+    std::size_t inputSize = 0;
+    Clock::time_point escapeDeadline; // When the bytes left in input stop waiting for the rest of a sequence
+    int bestScore = 0;
+    std::uint32_t tick = 0; // Ticks since the current game started
+    long long frames = 0;
+    long long bytes = 0;
+
+    {
+        TerminalSession session;
+        if (!session.isTerminal()) {
+            std::cerr << "Standard input is not a terminal" << std::endl;
+            return 1;
+        }
+
+        Clock::time_point nextTick = Clock::now() + tickTime;
+        bool dirty = true;
+        while (!gQuit) {
+            // Sleep until a key arrives, the next tick is due or a pending escape
+            // sequence times out, rounding up so the last fraction of a
+            // millisecond is not spent spinning
+            Clock::time_point wake = inputSize > 0 ? std::min(nextTick, escapeDeadline) : nextTick;
+            int timeoutMs = static_cast<int>(std::chrono::ceil<std::chrono::milliseconds>(wake - Clock::now()).count());
+            std::size_t pending = inputSize; // Bytes of an escape sequence left from before
+            pollfd descriptor = {STDIN_FILENO, POLLIN, 0};
+            if (poll(&descriptor, 1, timeoutMs > 0 ? timeoutMs : 0) > 0) {
+                ssize_t count = read(STDIN_FILENO, input + inputSize, sizeof(input) - inputSize);
+                if (count > 0) {
+                    inputSize += static_cast<std::size_t>(count);
+                }
+            }
+
+            // Terminals report presses only, and repeat held keys themselves
+            bool escapeTimedOut = pending > 0 && Clock::now() >= escapeDeadline;
+            std::size_t used = 0;
+            while (used < inputSize) {
+                Key key;
+                std::size_t length = decodeKey(input + used, inputSize - used, escapeTimedOut, key);
+                if (length == 0) {
+                    break;
+                }
+                used += length;
+                Simulation::Input move = Simulation::Input::None;
+                switch (key) {
+                    case Key::Left:    move = Simulation::Input::Left;     break;
+                    case Key::Right:   move = Simulation::Input::Right;    break;
+                    case Key::Up:      move = Simulation::Input::Rotate;   break;
+                    case Key::Down:    move = Simulation::Input::Down;     break;
+                    case Key::Space:   move = Simulation::Input::HardDrop; break;
+                    case Key::Quit:    gQuit = 1;                          break;
+                    case Key::Restart:
+                        if (simulation.isGameOver()) {
+                            simulation.reset();
+                            tick = 0;
+                            nextTick = Clock::now() + tickTime;
+                            dirty = true;
+                        }
+                        break;
+                    case Key::None:    break;
+                }
+                if (move != Simulation::Input::None) {
+                    simulation.step(move, 0.0f);
+                    dirty = true;
+                }
+            }
+            if (used < inputSize && (used > 0 || pending == 0)) {
+                escapeDeadline = Clock::now() + ESCAPE_TIMEOUT; // A new escape sequence is pending
+            }
+            inputSize -= used;
+            std::memmove(input, input + used, inputSize);
+
+            // Fixed ticks; after a stall, skip the backlog instead of replaying it
+            Clock::time_point now = Clock::now();
+            if (now >= nextTick) {
+                if (!simulation.isGameOver()) {
+                    simulation.step(Simulation::Input::None, tickSeconds);
+                    tick++;
+                    dirty = true;
+                    if (simulation.isGameOver()) {
+                        bestScore = std::max(bestScore, simulation.getScore());
+                    }
+                }
+                nextTick += tickTime;
+                if (now - nextTick > 5 * tickTime) {
+                    nextTick = now + tickTime;
+                }
+                if (spectators.isListening()) {
+                    spectators.publish(SpectatorSnapshot::capture(simulation, tick)); // Once per tick, game over included
+                }
+            }
+
+            if (gResized) {
+                gResized = 0;
+                screen.invalidate();
+                dirty = true;
+            }
+            if (!dirty) {
+                continue;
+            }
+            dirty = false;
+            drawGame(screen, simulation, std::max(bestScore, simulation.getScore()), style);
+            frame.clear();
+            screen.present(frame);
+            if (!frame.empty()) {
+                TerminalSession::write(frame);
+                frames++;
+                bytes += static_cast<long long>(frame.size());
+            }
+        }
+    }
+
+    std::cout << "Score " << simulation.getScore() << ", best " << std::max(bestScore, simulation.getScore())
+              << ". " << frames << " frames written, " << (frames > 0 ? bytes / frames : 0)
+              << " bytes per frame on average" << std::endl;
+    return 0;
+}